@@ -0,0 +1,62 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+// times a single-form edit against a full re-read of an ~11k line document,
+// run with no arguments
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <edncxx/ednincremental.h>
+#include <edncxx/utf8reader.h>
+
+using namespace edncxx;
+using Clock = std::chrono::steady_clock;
+
+int main()
+{
+    std::string text;
+    for(int ix = 0; ix < 11000; ++ix)
+        text += "[\"line" + std::to_string(ix) + "\" {\"k\" nil \"v\" [true false]}] ; trailing comment\n";
+
+    auto t0 = Clock::now();
+    IncrementalDocument doc(text);
+    auto full = Clock::now() - t0;
+
+    const int rounds = 1000;
+    auto at = doc.text().find("line5500") + 4;
+    Clock::duration edits{};
+    for(int ix = 0; ix < rounds; ++ix){
+        auto t1 = Clock::now();
+        doc.edit(at, 4, ix % 2 ? "5500" : "XXXX");
+        edits += Clock::now() - t1;
+    }
+
+    auto us = [](Clock::duration d){ return std::chrono::duration<double, std::micro>(d).count(); };
+    std::cout << std::fixed << std::setprecision(1)
+              << "forms " << doc.forms().size() << "  bytes " << doc.text().size() << '\n'
+              << "full read        " << std::setw(10) << us(full) << " us\n"
+              << "single-form edit " << std::setw(10) << us(edits) / rounds << " us\n";
+    return 0;
+}
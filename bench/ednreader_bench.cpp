@@ -0,0 +1,72 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+// times readValue over [[[...nil...]]] at a few nesting depths,
+// run with no arguments
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <edncxx/utf8reader.h>
+#include <edncxx/ednreader.h>
+#include <edncxx/ednrelease.h>
+
+using namespace edncxx;
+using Clock = std::chrono::steady_clock;
+
+static void bench(std::size_t depth)
+{
+    const std::string text = std::string(depth, '[') + "nil" + std::string(depth, ']');
+    ReadOptions opts;
+    opts.maxDepth = depth;
+
+    // about two million levels per depth, whatever the depth
+    const std::size_t rounds = std::max<std::size_t>(1, 2000000 / depth);
+    Clock::duration parsing{}, teardown{};
+    for(std::size_t ix = 0; ix < rounds; ++ix){
+        std::istringstream strm(text);
+        Utf8Reader rdr(strm);
+        auto t0 = Clock::now();
+        auto val = readValue(rdr, opts);
+        auto t1 = Clock::now();
+        release(std::move(*val));
+        auto t2 = Clock::now();
+        parsing += t1 - t0;
+        teardown += t2 - t1;
+    }
+
+    auto ns = [&](Clock::duration d){ return std::chrono::duration<double, std::nano>(d).count() / double(rounds); };
+    std::cout << "depth " << std::setw(7) << depth
+              << "  parse " << std::setw(12) << std::fixed << std::setprecision(0) << ns(parsing) << " ns"
+              << "  (" << std::setprecision(1) << ns(parsing) / double(depth) << " ns/level)"
+              << "  release " << std::setw(12) << std::setprecision(0) << ns(teardown) << " ns\n";
+}
+
+int main()
+{
+    for(std::size_t depth : {10u, 1000u, 100000u})
+        bench(depth);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+// times readValue over a vector of small records: plain, with a schema,
+// and checking against the schema without building.  run with no arguments
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <edncxx/utf8reader.h>
+#include <edncxx/ednreader.h>
+#include <edncxx/ednschema.h>
+
+using namespace edncxx;
+using Clock = std::chrono::steady_clock;
+
+// fastest of rounds, in milliseconds
+static double bench(const std::string& text, const ReadOptions& opts, int rounds)
+{
+    double best = 1e300;
+    for(int ix = 0; ix < rounds; ++ix){
+        std::istringstream strm(text);
+        Utf8Reader rdr(strm);
+        auto t0 = Clock::now();
+        auto val = readValue(rdr, opts);
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+    }
+    return best;
+}
+
+int main()
+{
+    std::string text = "[";
+    for(int ix = 0; ix < 20000; ++ix)
+        text += R"({"id" "r)" + std::to_string(ix) + R"(" "ok" true "note" nil "tags" #{"a" "b"}})";
+    text += "]";
+
+    Schema schema;
+    auto str = schema.scalar(T_String);
+    schema.root(schema.vector(schema.record({{StringType{U"id"}, str},
+                                             {StringType{U"ok"}, schema.scalar(T_Bool)},
+                                             {StringType{U"note"}, schema.nullable(str), false},
+                                             {StringType{U"tags"}, schema.set(str)}}, true)));
+    ReadOptions plain, checked, validated;
+    checked.schema = &schema;
+    validated.schema = &schema;
+    validated.validateOnly = true;
+
+    // interleaved, so drift in clock speed hits all of them alike
+    double a = 1e300, b = 1e300, c = 1e300;
+    for(int pass = 0; pass < 10; ++pass){
+        a = std::min(a, bench(text, plain, 5));
+        b = std::min(b, bench(text, checked, 5));
+        c = std::min(c, bench(text, validated, 5));
+    }
+    std::cout << std::fixed << std::setprecision(2)
+              << "plain    " << a << " ms\n"
+              << "schema   " << b << " ms  (+" << std::setprecision(1) << 100.0 * (b - a) / a << "%)\n"
+              << std::setprecision(2)
+              << "validate " << c << " ms\n";
+    return 0;
+}
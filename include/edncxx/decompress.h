@@ -0,0 +1,90 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace edncxx{
+
+    enum class Compression{ None, Gzip, Zstd };
+
+    // whether this build can decode the given format
+    bool decompressionSupported(Compression);
+
+    // DecompressBuf reads a gzip, zstd or plain byte stream, telling them apart
+    // by their magic bytes.  a worker thread decompresses into two alternating
+    // blocks while the reader consumes the other one straight out of the get
+    // area, so decompression and parsing overlap.
+    // decoding errors are rethrown from underflow().
+    class DecompressBuf : public std::streambuf{
+    public:
+        explicit DecompressBuf(std::istream& source, std::size_t blockSize = 1 << 16);
+        ~DecompressBuf() override;
+        Compression format() const { return _format; }
+
+        class Decoder;
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        struct Block{
+            std::vector<char> data;
+            std::size_t size = 0;
+            bool full = false;
+            bool last = false;
+        };
+
+        void produce();
+
+        Compression _format;
+        std::unique_ptr<Decoder> _decoder;
+        Block _blocks[2];
+        std::size_t _current = 0;
+        bool _holding = false;
+        bool _done = false;
+        bool _stop = false;
+        std::exception_ptr _error;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::thread _worker;
+    };
+
+    // istream over a DecompressBuf, hand it to Utf8Reader
+    class DecompressStream : public std::istream{
+    public:
+        explicit DecompressStream(std::istream& source, std::size_t blockSize = 1 << 16);
+        Compression format() const { return _buf.format(); }
+
+    private:
+        DecompressBuf _buf;
+    };
+}
@@ -23,16 +23,17 @@
 #pragma once
 #include <any>
 #include <string>
-#include <list>
-#include <vector>
 #include <typeindex>
-#include <unordered_map>
-#include <unordered_set>
+#include <edncxx/ednnode.h>
 
 namespace edncxx{
 
     using ValueType = std::any;
 
+    // structural hash/equality, values of different EdnType never compare equal
+    struct ValueHash  { std::size_t operator()(const ValueType&) const; };
+    struct ValueEqual { bool operator()(const ValueType&, const ValueType&) const; };
+
     struct NilType{};
     using BoolType = bool;
     using CharType = char32_t;
@@ -41,10 +42,12 @@ namespace edncxx{
     struct SymbolType  { std::u32string ns; std::u32string symbol; };
     using IntegerType = int64_t;
     using FloatType = double;
-    using ListType = std::list<ValueType>;
-    using VectorType = std::vector<ValueType>;
-    using MapType = std::unordered_map<ValueType, ValueType>;
-    using SetType = std::unordered_set<ValueType>;
+    struct ListTag{};
+    struct VectorTag{};
+    using ListType = Sequence<ValueType, ListTag>;
+    using VectorType = Sequence<ValueType, VectorTag>;
+    using MapType = FlatMap<ValueType, ValueType, ValueHash, ValueEqual>;
+    using SetType = FlatSet<ValueType, ValueHash, ValueEqual>;
     struct TaggedType  { std::u32string ns; std::u32string tag; ValueType rep; };
     struct DiscardType { ValueType discarded; };
 
@@ -53,6 +56,12 @@ namespace edncxx{
 
     EdnType edntype(const ValueType&);
     std::string typenameof(const ValueType&);
+    std::string typenameof(EdnType);
+    std::size_t hashof(const ValueType&);
+    // a second structural hash, seeded and mixed independently of hashof(),
+    // so a match on both is a 128 bit match
+    std::size_t hash2of(const ValueType&);
+    bool equals(const ValueType&, const ValueType&);
     
     template<typename T>
     bool is(const ValueType& v){  return std::type_index(typeid(T)) == std::type_index(v.type()); }
@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <edncxx/ednany.h>
+
+namespace edncxx{
+
+    enum class ColumnType{ Bool, Integer, Float, String, Keyword, Value };
+
+    // one keyword's values across all rows, stored contiguously by type.
+    // strings and keywords are dictionary encoded, mixed or other values
+    // land in a Value column.  rows without the key (or with nil) are null.
+    struct Column{
+        KeywordType name;
+        ColumnType type = ColumnType::Value;
+        std::vector<std::uint64_t> valid;       // bitmap, bit set when the row has a value
+        std::vector<std::uint8_t> bools;        // Bool
+        std::vector<IntegerType> integers;      // Integer
+        std::vector<FloatType> floats;          // Float
+        std::vector<std::uint32_t> codes;       // String / Keyword, index into dictionary
+        std::vector<ValueType> dictionary;      // String / Keyword, distinct values
+        std::vector<ValueType> values;          // Value
+
+        bool isNull(std::size_t row) const { return !(valid[row / 64] >> (row % 64) & 1); }
+        // the row's value as a ValueType again, NilType for nulls
+        ValueType at(std::size_t row) const;
+    };
+
+    struct ColumnarTable{
+        std::size_t rows = 0;
+        std::vector<Column> columns;            // in order of first appearance
+
+        const Column* column(const KeywordType& name) const;
+    };
+
+    // struct-of-arrays view of a vector or list of maps keyed by keywords.
+    // nullopt when the value is not such a sequence.
+    std::optional<ColumnarTable> toColumnar(const ValueType& rows);
+}
@@ -0,0 +1,60 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <unordered_set>
+#include <edncxx/ednany.h>
+
+namespace edncxx{
+
+    // DedupTable hash-conses collections: structurally equal lists, vectors,
+    // maps and sets come back sharing a single node, so equal subtrees cost
+    // one allocation and compare equal by pointer.
+    // pass one to readValue() through ReadOptions, either per document or
+    // shared across documents (prune() then drops entries only the table
+    // still holds).  not thread safe.
+    class DedupTable{
+    public:
+        // canonical value equal to v; scalars are passed through untouched
+        ValueType intern(ValueType v);
+
+        std::size_t size() const { return _values.size(); }
+        std::size_t hits() const { return _hits; }
+        // estimate of heap bytes released by sharing instead of keeping copies
+        std::size_t bytesSaved() const { return _bytesSaved; }
+
+        void prune();
+        void clear();
+
+    private:
+        // bit identity rather than equals(): 0.0 and -0.0 are kept apart and
+        // a NaN matches itself, so sharing never changes a value
+        struct SameHash  { std::size_t operator()(const ValueType&) const; };
+        struct SameValue { bool operator()(const ValueType&, const ValueType&) const; };
+
+        std::unordered_set<ValueType, SameHash, SameValue> _values;
+        std::size_t _hits = 0;
+        std::size_t _bytesSaved = 0;
+    };
+}
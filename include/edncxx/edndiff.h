@@ -0,0 +1,57 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <edncxx/ednany.h>
+
+namespace edncxx{
+
+    struct Change{
+        enum Kind{ Added, Removed, Changed };
+        Kind kind;
+        // map keys and list/vector indices (IntegerType) from the root down.
+        // set members are added or removed at the path of their set.
+        std::vector<ValueType> path;
+        ValueType before;               // empty for Added
+        ValueType after;                // empty for Removed
+    };
+
+    struct DiffOptions{
+        // collections with at least this many children to compare have them
+        // split across std::async tasks, 0 keeps everything on the caller
+        std::size_t parallelThreshold = 0;
+        // confirm subtrees whose hashes match with equals(), a full walk of
+        // each, rather than trusting the 128 bit match
+        bool verify = false;
+    };
+
+    // what changed from before to after, in depth first order.  subtrees that
+    // share a node are skipped at once, otherwise hashof() and hash2of() are
+    // compared: a mismatch is a difference and a match on both is taken as
+    // equal, so neither needs a walk once the hashes are memoized (reading
+    // with ReadOptions::hash has them ready).  lists and vectors are compared
+    // index by index, map entries are matched by key.
+    std::vector<Change> diff(const ValueType& before, const ValueType& after, const DiffOptions& options = {});
+}
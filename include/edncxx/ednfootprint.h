@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include <edncxx/ednany.h>
+
+namespace edncxx{
+
+    // memory held by the values of one EdnType.  every value is charged for
+    // its slot in the parent (or nothing at the root), the box std::any puts
+    // it in if it does not fit the slot, and whatever it allocates itself;
+    // collection elements are charged to their own types.
+    struct TypeFootprint{
+        std::size_t count = 0;          // values seen
+        std::size_t payload = 0;        // content: characters, inline scalars
+        std::size_t overhead = 0;       // headers, boxes, indexes, terminators
+        std::size_t slack = 0;          // unused string / collection capacity
+        std::size_t allocations = 0;    // heap blocks
+
+        std::size_t bytes() const { return payload + overhead + slack; }
+        TypeFootprint& operator+=(const TypeFootprint&);
+    };
+
+    struct Footprint{
+        TypeFootprint types[T_Discard + 1];
+        bool sampled = false;           // figures are extrapolated estimates
+
+        const TypeFootprint& operator[](EdnType type) const { return types[type]; }
+        TypeFootprint total() const;
+    };
+
+    // walks the whole tree, shared nodes are counted once
+    Footprint footprint(const ValueType& root);
+
+    // estimate for huge trees: collections with more than a few dozen
+    // elements have only every 1/sampleRate-th element walked, the result is
+    // scaled up to the full count.  sampleRate is clamped to (0, 1].
+    Footprint footprint(const ValueType& root, double sampleRate);
+
+    // one line per type present, then the total
+    std::ostream& operator<<(std::ostream&, const Footprint&);
+}
@@ -0,0 +1,68 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <edncxx/ednany.h>
+#include <edncxx/ednreader.h>
+
+namespace edncxx{
+
+    // IncrementalDocument holds a source text together with its top-level
+    // forms and the byte range each was read from.  edit() splices the text
+    // and re-reads only from the first form the edit touches up to the point
+    // where reading falls back in step with the old forms; every other form
+    // keeps its value (and so its nodes) untouched.
+    class IncrementalDocument{
+    public:
+        struct Form{
+            std::size_t begin;      // where reading started, leading whitespace and comments included
+            std::size_t end;        // one past the form's last byte
+            ValueType value;
+        };
+
+        explicit IncrementalDocument(std::string text, ReadOptions options = {});
+
+        // replaces `removed` bytes at `offset` with `inserted`.  throws
+        // std::runtime_error if the result does not read, the text keeps the
+        // edit and the next edit re-reads the whole document.
+        void edit(std::size_t offset, std::size_t removed, std::string_view inserted);
+
+        const std::string& text() const { return _text; }
+        const std::vector<Form>& forms() const { return _forms; }
+        // forms read by the last edit (or the constructor)
+        std::size_t lastReparsed() const { return _lastReparsed; }
+
+    private:
+        void reparse(std::size_t start, std::size_t editEnd, std::ptrdiff_t delta, std::size_t first);
+
+        std::string _text;
+        ReadOptions _options;
+        std::vector<Form> _forms;
+        std::size_t _lastReparsed = 0;
+        bool _stale = false;
+    };
+}
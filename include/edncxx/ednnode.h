@@ -0,0 +1,403 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace edncxx{
+
+    // collections are pointer-sized handles onto a single reference counted
+    // node, elements are laid out contiguously right behind the node header.
+    // std::any keeps the handle in its own small buffer, so a collection costs
+    // one allocation no matter how short it is.  copies share the node, the
+    // first mutation through a shared handle takes a private copy.
+    namespace detail{
+
+        // node storage, served from the calling thread's free lists when
+        // release() has recycled nodes into them (see ednrelease.h)
+        void* allocNode(std::size_t bytes);
+        void freeNode(void* mem, std::size_t bytes);
+
+        template<typename T>
+        struct Node{
+            std::atomic<std::size_t> refs{1};
+            std::size_t size = 0;
+            std::size_t capacity = 0;
+            std::uint32_t* index = nullptr;   // open addressing slots (entry+1), tables only
+            std::size_t slots = 0;
+            std::atomic<std::size_t> hash{0};  // structural hash memo, 0 = not yet computed
+            std::atomic<std::size_t> hash2{0}; // same for the independently seeded hash2of()
+
+            static constexpr std::size_t dataOffset(){
+                return (sizeof(Node) + alignof(T) - 1) / alignof(T) * alignof(T);
+            }
+            T* data(){ return reinterpret_cast<T*>(reinterpret_cast<char*>(this) + dataOffset()); }
+            const T* data() const { return reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + dataOffset()); }
+
+            static std::size_t bytesFor(std::size_t capacity){ return dataOffset() + capacity * sizeof(T); }
+
+            static Node* make(std::size_t capacity){
+                void* mem = allocNode(bytesFor(capacity));
+                auto node = new(mem) Node;
+                node->capacity = capacity;
+                return node;
+            }
+
+            static void destroy(Node* node){
+                std::destroy_n(node->data(), node->size);
+                delete[] node->index;
+                auto bytes = bytesFor(node->capacity);
+                node->~Node();
+                freeNode(node, bytes);
+            }
+        };
+
+        template<typename T>
+        class NodeRef{
+        public:
+            NodeRef() noexcept = default;
+            explicit NodeRef(Node<T>* node) noexcept : _node(node) {}
+            NodeRef(const NodeRef& other) noexcept : _node(other._node) {
+                if(_node) _node->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+            NodeRef(NodeRef&& other) noexcept : _node(other._node) { other._node = nullptr; }
+            NodeRef& operator=(NodeRef other) noexcept { std::swap(_node, other._node); return *this; }
+            ~NodeRef(){ reset(); }
+
+            void reset() noexcept {
+                if(_node && _node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    Node<T>::destroy(_node);
+                _node = nullptr;
+            }
+            Node<T>* get() const noexcept { return _node; }
+            bool shared() const noexcept { return _node && _node->refs.load(std::memory_order_acquire) > 1; }
+
+        private:
+            Node<T>* _node = nullptr;
+        };
+
+        // yields a node we own outright with room for at least `need` elements,
+        // copying out of a shared node or moving out of an undersized one
+        template<typename T>
+        Node<T>* ownNode(NodeRef<T>& ref, std::size_t need)
+        {
+            auto old = ref.get();
+            bool shared = ref.shared();
+            if(old && !shared && old->capacity >= need){
+                old->hash.store(0, std::memory_order_relaxed);
+                old->hash2.store(0, std::memory_order_relaxed);
+                return old;
+            }
+
+            std::size_t capacity = need;
+            if(old && old->capacity >= need)
+                capacity = old->capacity;
+            else if(old)
+                capacity = std::max(need, 2 * old->capacity);
+
+            auto fresh = Node<T>::make(capacity);
+            try{
+                if(old){
+                    for(auto ix = 0u; ix < old->size; ++ix){
+                        if(shared) new(fresh->data() + ix) T(old->data()[ix]);
+                        else new(fresh->data() + ix) T(std::move(old->data()[ix]));
+                        ++fresh->size;
+                    }
+                    if(old->index && !shared){
+                        fresh->index = std::exchange(old->index, nullptr);
+                        fresh->slots = old->slots;
+                    } else if(old->index){
+                        fresh->index = new std::uint32_t[old->slots];
+                        std::copy_n(old->index, old->slots, fresh->index);
+                        fresh->slots = old->slots;
+                    }
+                }
+            } catch(...){
+                Node<T>::destroy(fresh);
+                throw;
+            }
+            ref = NodeRef<T>(fresh);
+            return fresh;
+        }
+
+        // what every collection handle can tell about its node
+        template<typename T>
+        class Handle{
+        public:
+            using size_type = std::size_t;
+            using const_iterator = const T*;
+
+            size_type size() const noexcept { return _node.get() ? _node.get()->size : 0; }
+            size_type capacity() const noexcept { return _node.get() ? _node.get()->capacity : 0; }
+            bool empty() const noexcept { return size() == 0; }
+
+            const_iterator begin() const noexcept { return _node.get() ? _node.get()->data() : nullptr; }
+            const_iterator end() const noexcept { return begin() + size(); }
+
+            // true when both handles refer to the very same node
+            bool shares(const Handle& other) const noexcept { return _node.get() == other._node.get(); }
+            const void* identity() const noexcept { return _node.get(); }
+            std::size_t useCount() const noexcept { return _node.get() ? _node.get()->refs.load(std::memory_order_relaxed) : 0; }
+
+            std::size_t indexBytes() const noexcept { return _node.get() ? _node.get()->slots * sizeof(std::uint32_t) : 0; }
+            static constexpr std::size_t headerBytes(){ return Node<T>::dataOffset(); }
+
+            // bytes allocated for the node and its index
+            std::size_t allocated() const noexcept {
+                auto node = _node.get();
+                if(!node) return 0;
+                return Node<T>::bytesFor(node->capacity) + node->slots * sizeof(std::uint32_t);
+            }
+
+            // memo for hashof(), mutations clear it
+            std::size_t cachedHash() const noexcept { return _node.get() ? _node.get()->hash.load(std::memory_order_relaxed) : 0; }
+            void cacheHash(std::size_t h) const noexcept { if(_node.get()) _node.get()->hash.store(h, std::memory_order_relaxed); }
+            // memo for hash2of()
+            std::size_t cachedHash2() const noexcept { return _node.get() ? _node.get()->hash2.load(std::memory_order_relaxed) : 0; }
+            void cacheHash2(std::size_t h) const noexcept { if(_node.get()) _node.get()->hash2.store(h, std::memory_order_relaxed); }
+
+            void clear() noexcept { _node.reset(); }
+
+            // sole owner: elements are moved out to sink one by one, so the
+            // node itself dies shallow.  shared: only this handle lets go.
+            template<typename Sink>
+            void drain(Sink&& sink){
+                auto node = _node.get();
+                if(node && !_node.shared()){
+                    for(auto ix = 0u; ix < node->size; ++ix)
+                        sink(std::move(node->data()[ix]));
+                }
+                _node.reset();
+            }
+
+        protected:
+            NodeRef<T> _node;
+        };
+    }
+
+    // contiguous sequence, Tag keeps lists and vectors apart as types
+    template<typename T, typename Tag>
+    class Sequence : public detail::Handle<T>{
+        using detail::Handle<T>::_node;
+    public:
+        using value_type = T;
+        using typename detail::Handle<T>::size_type;
+        using detail::Handle<T>::size;
+        using detail::Handle<T>::capacity;
+        using detail::Handle<T>::begin;
+
+        Sequence() noexcept = default;
+        Sequence(std::initializer_list<T> items) : Sequence(items.begin(), items.end()) {}
+
+        template<typename It>
+        Sequence(It first, It last){
+            reserve(static_cast<size_type>(std::distance(first, last)));
+            for(; first != last; ++first)
+                push_back(*first);
+        }
+
+        const T& operator[](size_type ix) const { return begin()[ix]; }
+        const T& at(size_type ix) const {
+            if(ix >= size()) throw std::out_of_range("Sequence::at");
+            return begin()[ix];
+        }
+        const T& front() const { return begin()[0]; }
+        const T& back() const { return begin()[size() - 1]; }
+
+        void reserve(size_type n){ if(n > capacity() || _node.shared()) detail::ownNode(_node, std::max(n, size())); }
+
+        void push_back(T value){
+            auto node = detail::ownNode(_node, size() + 1);
+            new(node->data() + node->size) T(std::move(value));
+            ++node->size;
+        }
+
+        void pop_back(){
+            auto node = detail::ownNode(_node, size());
+            std::destroy_at(node->data() + --node->size);
+        }
+
+        void set(size_type ix, T value){
+            auto node = detail::ownNode(_node, size());
+            node->data()[ix] = std::move(value);
+        }
+    };
+
+    // hashed table over contiguous entries.  up to FlatLimit entries lookup
+    // is a linear scan, past that an open addressing index is kept alongside.
+    template<typename Entry, typename Key, typename KeyOf, typename Hash, typename Eq>
+    class Table : public detail::Handle<Entry>{
+        using detail::Handle<Entry>::_node;
+    public:
+        static constexpr std::size_t FlatLimit = 8;
+        using value_type = Entry;
+        using typename detail::Handle<Entry>::size_type;
+        using detail::Handle<Entry>::size;
+        using detail::Handle<Entry>::begin;
+
+        bool hashed() const noexcept { return _node.get() && _node.get()->index; }
+        bool contains(const Key& key) const { return lookup(key) != nullptr; }
+        // the stored entry whose key is Eq to key, or nullptr
+        const Entry* findEntry(const Key& key) const { return lookup(key); }
+
+        // sizing up front picks the representation once rather than promoting later
+        void reserve(size_type n){
+            if(n == 0) return;
+            auto node = detail::ownNode(_node, std::max(n, size()));
+            if(n > FlatLimit && node->slots < 2 * n)
+                reindex(node, n);
+        }
+
+        bool erase(const Key& key){
+            auto found = lookup(key);
+            if(!found) return false;
+            auto ix = static_cast<size_type>(found - begin());
+            auto node = detail::ownNode(_node, size());
+            auto data = node->data();
+            std::move(data + ix + 1, data + node->size, data + ix);
+            std::destroy_at(data + --node->size);
+            if(node->index) reindex(node, node->capacity);
+            return true;
+        }
+
+    protected:
+        const Entry* lookup(const Key& key) const {
+            auto node = _node.get();
+            if(!node) return nullptr;
+            auto data = node->data();
+            if(!node->index){
+                for(auto ix = 0u; ix < node->size; ++ix)
+                    if(Eq{}(KeyOf{}(data[ix]), key)) return data + ix;
+                return nullptr;
+            }
+            auto mask = node->slots - 1;
+            for(auto slot = Hash{}(key) & mask; node->index[slot]; slot = (slot + 1) & mask){
+                auto& entry = data[node->index[slot] - 1];
+                if(Eq{}(KeyOf{}(entry), key)) return &entry;
+            }
+            return nullptr;
+        }
+
+        Entry* lookupOwned(const Key& key){
+            auto found = lookup(key);
+            if(!found) return nullptr;
+            auto ix = found - begin();
+            return detail::ownNode(_node, size())->data() + ix;
+        }
+
+        // appends without checking for an existing key
+        void append(Entry entry){
+            auto node = detail::ownNode(_node, size() + 1);
+            new(node->data() + node->size) Entry(std::move(entry));
+            ++node->size;
+            if(node->index && node->slots >= 2 * node->size)
+                place(node, node->size - 1);
+            else if(node->size > FlatLimit)
+                reindex(node, node->capacity);
+        }
+
+    private:
+        static void place(detail::Node<Entry>* node, size_type ix){
+            auto mask = node->slots - 1;
+            auto slot = Hash{}(KeyOf{}(node->data()[ix])) & mask;
+            while(node->index[slot]) slot = (slot + 1) & mask;
+            node->index[slot] = static_cast<std::uint32_t>(ix + 1);
+        }
+
+        static void reindex(detail::Node<Entry>* node, size_type n){
+            size_type slots = 16;
+            while(slots < 2 * n) slots *= 2;
+            auto index = new std::uint32_t[slots]();
+            delete[] node->index;
+            node->index = index;
+            node->slots = slots;
+            for(auto ix = 0u; ix < node->size; ++ix)
+                place(node, ix);
+        }
+    };
+
+    namespace detail{
+        template<typename K, typename V> struct FirstOf { const K& operator()(const std::pair<K,V>& e) const { return e.first; } };
+        template<typename T> struct Identity { const T& operator()(const T& e) const { return e; } };
+    }
+
+    template<typename K, typename V, typename Hash, typename Eq>
+    class FlatMap : public Table<std::pair<K,V>, K, detail::FirstOf<K,V>, Hash, Eq>{
+    public:
+        FlatMap() noexcept = default;
+        FlatMap(std::initializer_list<std::pair<K,V>> entries){
+            this->reserve(entries.size());
+            for(auto& e : entries) insert(e.first, e.second);
+        }
+
+        const V* find(const K& key) const {
+            auto entry = this->lookup(key);
+            return entry ? &entry->second : nullptr;
+        }
+
+        const V& at(const K& key) const {
+            auto value = find(key);
+            if(!value) throw std::out_of_range("FlatMap::at");
+            return *value;
+        }
+
+        // false (and no change) when the key is already present
+        bool insert(K key, V value){
+            if(this->lookup(key)) return false;
+            this->append({std::move(key), std::move(value)});
+            return true;
+        }
+
+        void insert_or_assign(K key, V value){
+            if(auto entry = this->lookupOwned(key))
+                entry->second = std::move(value);
+            else
+                this->append({std::move(key), std::move(value)});
+        }
+    };
+
+    template<typename T, typename Hash, typename Eq>
+    class FlatSet : public Table<T, T, detail::Identity<T>, Hash, Eq>{
+    public:
+        FlatSet() noexcept = default;
+        FlatSet(std::initializer_list<T> items){
+            this->reserve(items.size());
+            for(auto& item : items) insert(item);
+        }
+
+        bool insert(T item){
+            if(this->lookup(item)) return false;
+            this->append(std::move(item));
+            return true;
+        }
+    };
+
+} // namespace
@@ -21,9 +21,37 @@
 // THE SOFTWARE.
 
 #pragma once
-#include <optional>
 #include <any>
+#include <cstddef>
+#include <optional>
 namespace edncxx{
     class Utf8Reader;
+    class DedupTable;
+    class Schema;
+
+    struct ReadOptions{
+        DedupTable* dedup = nullptr;    // when set, collections are hash-consed through it
+        // nesting beyond this is rejected with std::runtime_error, leaving the
+        // reader just past the opening delimiter that went too deep (the
+        // parse stacks are reset, the reader is not rewound).  reading is
+        // iterative at any depth, but destructors recurse: about 450 bytes of
+        // stack per level unoptimised, 50 optimised, so the default fits a
+        // 1 MiB stack.  tear deeper trees down with release() (ednrelease.h).
+        std::size_t maxDepth = 1000;
+        // when set, every form is checked against it as it is read and the
+        // first one that does not match throws SchemaError (ednschema.h)
+        const Schema* schema = nullptr;
+        // memoize every collection's structural hashes (hashof and hash2of) as
+        // it is read, so that diff() and equals() can settle whole subtrees
+        // without a walk
+        bool hash = false;
+        // check the input, with the schema if there is one, without building
+        // values: each form read yields NilType.  only map keys are kept
+        // while their map is open, so duplicates go unnoticed except for
+        // the keys a schema record names.
+        bool validateOnly = false;
+    };
+
     std::optional<std::any> readValue(Utf8Reader& reader);
+    std::optional<std::any> readValue(Utf8Reader& reader, const ReadOptions& options);
 }
@@ -0,0 +1,47 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <edncxx/ednany.h>
+
+namespace edncxx{
+
+    // how release() disposes of a tree
+    enum class Reclaim{
+        Now,            // free on the calling thread
+        Recycle,        // keep freed nodes on this thread's free lists for the next parse
+        Background      // hand the tree to the reclaimer thread and return at once
+    };
+
+    // tears a value tree down iteratively, so depth cannot overflow the stack.
+    // subtrees still shared with other values are left alone.
+    void release(ValueType&& value, Reclaim how = Reclaim::Now);
+
+    // waits until the reclaimer thread has freed everything handed to it
+    void flushReclaimer();
+
+    // bytes sitting on this thread's node free lists, and giving them back
+    std::size_t cachedNodeBytes();
+    void trimNodeCache();
+}
@@ -0,0 +1,111 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <edncxx/ednany.h>
+
+namespace edncxx{
+
+    // a schema compiled to a flat table of nodes.  nodes are built bottom up,
+    // each builder call returns the Ref of the node it added, and root() picks
+    // the node top level forms must match.  set ReadOptions::schema to have
+    // readValue() check every form as it is read.
+    class Schema{
+    public:
+        using Ref = std::uint32_t;
+
+        struct Field{
+            ValueType key;
+            Ref value = 0;
+            bool required = true;
+        };
+
+        struct Node{
+            EdnType kind = T_Invalid;   // T_Invalid accepts anything
+            bool nullable = false;      // nil is accepted as well
+            bool record = false;        // T_Map with per-key value schemas
+            bool closed = false;        // record: keys outside the fields are rejected
+            Ref key = 0;                // T_Map: schema of every key
+            Ref value = 0;              // element, map value or tagged rep
+            std::uint32_t first = 0;    // record: fields()[first, first + count)
+            std::uint32_t count = 0;
+            std::uint32_t required = 0; // record: how many of those are required
+            std::u32string ns, tag;     // T_Tagged
+        };
+
+        Schema();
+
+        Ref any() const { return 0; }
+        Ref scalar(EdnType kind);       // T_Nil ... T_Float
+        Ref list(Ref element);
+        Ref vector(Ref element);
+        Ref set(Ref element);
+        Ref map(Ref key, Ref value);
+        Ref record(std::vector<Field> fields, bool closed = false);
+        Ref tagged(std::u32string ns, std::u32string tag, Ref rep);
+        Ref nullable(Ref ref);
+
+        void root(Ref ref);
+        Ref root() const { return _root; }
+
+        const Node& node(Ref ref) const { return _nodes[ref]; }
+        bool accepts(Ref ref, EdnType kind) const;
+        // the record's field for key, nullptr when there is none.  kind is
+        // edntype(key), for callers that know it already.
+        const Field* field(Ref record, const ValueType& key) const;
+        const Field* field(Ref record, const ValueType& key, EdnType kind) const;
+        const Field* fieldsOf(Ref record) const { return _fields.data() + _nodes[record].first; }
+
+    private:
+        static constexpr std::uint32_t ScanLimit = 8;  // records up to this many fields are scanned, not hashed
+
+        Ref add(Node node);
+        void check(Ref ref) const;
+
+        std::vector<Node> _nodes;
+        std::vector<Field> _fields;
+        std::vector<EdnType> _kinds;        // parallel to _fields
+        // parallel to _fields, each record's run sorted by key hash
+        std::vector<std::pair<std::size_t, std::uint32_t>> _byHash;
+        Ref _root = 0;
+    };
+
+    // thrown by readValue() when a form does not match ReadOptions::schema
+    class SchemaError : public std::runtime_error{
+    public:
+        SchemaError(const std::string& what, std::string path, std::size_t offset);
+
+        const std::string& path() const { return _path; }   // e.g. [3 :name]
+        std::size_t offset() const { return _offset; }      // byte offset of the offending form
+
+    private:
+        std::string _path;
+        std::size_t _offset;
+    };
+}
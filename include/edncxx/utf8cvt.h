@@ -20,11 +20,44 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+
+#pragma once
+#include <cstddef>
 #include <string>
-#include <locale>
+#include <string_view>
 
 namespace edncxx{
 
+    // allocating conversions, throw std::runtime_error on malformed input
     std::string encodeUtf8(const std::u32string& from);
     std::u32string decodeUtf8(const std::string& from);
+    std::u16string encodeUtf16(const std::u32string& from);
+    std::u16string utf8ToUtf16(const std::string& from);
+
+    // exact output sizes in code units, input assumed well formed
+    std::size_t utf8LengthOf(std::u32string_view from);
+    std::size_t utf16LengthOf(std::u32string_view from);
+    std::size_t utf32LengthOf(std::string_view from);
+    std::size_t utf16LengthOf(std::string_view from);
+
+    // outcome of a conversion into a caller supplied buffer.  on failure
+    // `read` is the offset of the offending input unit; running out of
+    // output space also fails, with `read` at the first unconverted unit.
+    struct CvtResult{
+        bool ok = true;
+        std::size_t read = 0;       // input units consumed
+        std::size_t written = 0;    // output units produced
+    };
+
+    // validating conversions, stop at the first bad code point / sequence
+    CvtResult encodeUtf8(std::u32string_view from, char* to, std::size_t capacity);
+    CvtResult encodeUtf16(std::u32string_view from, char16_t* to, std::size_t capacity);
+    CvtResult decodeUtf8(std::string_view from, char32_t* to, std::size_t capacity);
+    CvtResult utf8ToUtf16(std::string_view from, char16_t* to, std::size_t capacity);
+
+    // non-validating conversions for trusted input, `to` must hold the
+    // length reported by the *LengthOf() functions.  return units written.
+    std::size_t encodeUtf8Unchecked(std::u32string_view from, char* to);
+    std::size_t decodeUtf8Unchecked(std::string_view from, char32_t* to);
+    std::size_t utf8ToUtf16Unchecked(std::string_view from, char16_t* to);
 }
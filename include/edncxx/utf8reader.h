@@ -42,14 +42,18 @@ namespace edncxx{
         char32_t peek();
         void unget(char32_t);
         void unget(const std::u32string_view&);
+        // both stop at end of input as well
         std::u32string getWhile(std::function<bool(char32_t)> pred);
         std::u32string getUntil(std::function<bool(char32_t)> pred);
         using Location = std::pair<unsigned, unsigned>;
         const Location& loc() const { return _loc; }
+        // bytes of the source consumed so far, net of unget()
+        std::size_t offset() const { return _offset; }
 
     private:
         std::istream& _source;
         std::vector<char32_t> _pushback;
         Location _loc;
+        std::size_t _offset = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/decompress.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef EDNCXX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef EDNCXX_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace edncxx;
+namespace edncxx{
+
+bool decompressionSupported(Compression format)
+{
+    switch(format){
+        case Compression::None: return true;
+#ifdef EDNCXX_HAVE_ZLIB
+        case Compression::Gzip: return true;
+#endif
+#ifdef EDNCXX_HAVE_ZSTD
+        case Compression::Zstd: return true;
+#endif
+        default: return false;
+    }
+}
+
+// pulls compressed input from the source, the first few bytes having
+// already been read for format detection
+class DecompressBuf::Decoder{
+public:
+    Decoder(std::istream& source, std::vector<char> prefix, std::size_t inSize)
+        : _source(source), _in(std::move(prefix))
+    {
+        _avail = _in.size();
+        _in.resize(std::max(inSize, _in.size()));
+    }
+    virtual ~Decoder() = default;
+
+    // fills out with up to cap bytes, sets end once the stream is exhausted
+    virtual std::size_t fill(char* out, std::size_t cap, bool& end) = 0;
+
+protected:
+    // refills the input buffer, false at end of source
+    bool refill(){
+        if(_avail) return true;
+        _source.read(_in.data(), _in.size());
+        _avail = static_cast<std::size_t>(_source.gcount());
+        _next = 0;
+        return _avail != 0;
+    }
+
+    std::istream& _source;
+    std::vector<char> _in;
+    std::size_t _next = 0;
+    std::size_t _avail = 0;
+};
+
+namespace{
+
+    class PlainDecoder : public DecompressBuf::Decoder{
+    public:
+        using Decoder::Decoder;
+        std::size_t fill(char* out, std::size_t cap, bool& end) override {
+            std::size_t n = 0;
+            while(n < cap && refill()){
+                auto take = std::min(cap - n, _avail);
+                std::memcpy(out + n, _in.data() + _next, take);
+                _next += take;
+                _avail -= take;
+                n += take;
+            }
+            end = n < cap;
+            return n;
+        }
+    };
+
+#ifdef EDNCXX_HAVE_ZLIB
+    class GzipDecoder : public DecompressBuf::Decoder{
+    public:
+        GzipDecoder(std::istream& source, std::vector<char> prefix, std::size_t inSize)
+            : Decoder(source, std::move(prefix), inSize)
+        {
+            std::memset(&_zs, 0, sizeof(_zs));
+            if(inflateInit2(&_zs, 15 + 16) != Z_OK)
+                throw std::runtime_error("gzip: inflateInit2 failed");
+        }
+        ~GzipDecoder() override { inflateEnd(&_zs); }
+
+        std::size_t fill(char* out, std::size_t cap, bool& end) override {
+            std::size_t n = 0;
+            end = false;
+            while(n < cap){
+                if(!refill()){
+                    if(_inMember)
+                        throw std::runtime_error("gzip: truncated input");
+                    end = true;
+                    break;
+                }
+                _zs.next_in = reinterpret_cast<Bytef*>(_in.data() + _next);
+                _zs.avail_in = static_cast<uInt>(_avail);
+                _zs.next_out = reinterpret_cast<Bytef*>(out + n);
+                _zs.avail_out = static_cast<uInt>(cap - n);
+                _inMember = true;
+                auto rc = inflate(&_zs, Z_NO_FLUSH);
+                n = cap - _zs.avail_out;
+                _next += _avail - _zs.avail_in;
+                _avail = _zs.avail_in;
+                if(rc == Z_STREAM_END){
+                    // concatenated members are one stream as far as gzip goes
+                    _inMember = false;
+                    inflateReset(&_zs);
+                }
+                else if(rc != Z_OK && rc != Z_BUF_ERROR){
+                    std::ostringstream msg;
+                    msg << "gzip: inflate failed: " << (_zs.msg ? _zs.msg : "") << " (" << rc << ")";
+                    throw std::runtime_error(msg.str());
+                }
+            }
+            return n;
+        }
+
+    private:
+        z_stream _zs;
+        bool _inMember = false;
+    };
+#endif
+
+#ifdef EDNCXX_HAVE_ZSTD
+    class ZstdDecoder : public DecompressBuf::Decoder{
+    public:
+        ZstdDecoder(std::istream& source, std::vector<char> prefix, std::size_t)
+            : Decoder(source, std::move(prefix), ZSTD_DStreamInSize())
+        {
+            _ds = ZSTD_createDStream();
+            if(!_ds) throw std::runtime_error("zstd: ZSTD_createDStream failed");
+            ZSTD_initDStream(_ds);
+        }
+        ~ZstdDecoder() override { ZSTD_freeDStream(_ds); }
+
+        std::size_t fill(char* out, std::size_t cap, bool& end) override {
+            ZSTD_outBuffer output{out, cap, 0};
+            end = false;
+            while(output.pos < output.size){
+                bool more = refill();
+                if(!more && !_pending){
+                    end = true;
+                    break;
+                }
+                // with the source exhausted the decoder may still hold output
+                // from the last block, an empty input lets it flush that
+                ZSTD_inBuffer input{_in.data() + _next, _avail, 0};
+                auto before = output.pos;
+                auto rc = ZSTD_decompressStream(_ds, &output, &input);
+                if(ZSTD_isError(rc)){
+                    std::ostringstream msg;
+                    msg << "zstd: " << ZSTD_getErrorName(rc);
+                    throw std::runtime_error(msg.str());
+                }
+                if(!more && rc != 0 && output.pos == before)
+                    throw std::runtime_error("zstd: truncated input");
+                _pending = rc != 0;
+                _next += input.pos;
+                _avail -= input.pos;
+            }
+            return output.pos;
+        }
+
+    private:
+        ZSTD_DStream* _ds;
+        bool _pending = false;
+    };
+#endif
+
+    Compression detect(const std::vector<char>& prefix)
+    {
+        auto at = [&](std::size_t ix){ return ix < prefix.size() ? static_cast<unsigned char>(prefix[ix]) : 0u; };
+        if(at(0) == 0x1f && at(1) == 0x8b) return Compression::Gzip;
+        if(at(0) == 0x28 && at(1) == 0xb5 && at(2) == 0x2f && at(3) == 0xfd) return Compression::Zstd;
+        return Compression::None;
+    }
+}
+
+DecompressBuf::DecompressBuf(std::istream& source, std::size_t blockSize)
+{
+    // empty blocks would read as neither data nor end of input
+    if(!blockSize)
+        throw std::runtime_error("DecompressBuf: blockSize must not be 0");
+    std::vector<char> prefix(4);
+    source.read(prefix.data(), prefix.size());
+    prefix.resize(static_cast<std::size_t>(source.gcount()));
+    _format = detect(prefix);
+    if(!decompressionSupported(_format))
+        throw std::runtime_error("DecompressBuf: input is compressed in a format this build does not support");
+
+    switch(_format){
+#ifdef EDNCXX_HAVE_ZLIB
+        case Compression::Gzip: _decoder = std::make_unique<GzipDecoder>(source, std::move(prefix), blockSize); break;
+#endif
+#ifdef EDNCXX_HAVE_ZSTD
+        case Compression::Zstd: _decoder = std::make_unique<ZstdDecoder>(source, std::move(prefix), blockSize); break;
+#endif
+        default:                _decoder = std::make_unique<PlainDecoder>(source, std::move(prefix), blockSize); break;
+    }
+    for(auto& block : _blocks)
+        block.data.resize(blockSize);
+    _worker = std::thread([this]{ produce(); });
+}
+
+DecompressBuf::~DecompressBuf()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _changed.notify_all();
+    _worker.join();
+}
+
+void DecompressBuf::produce()
+{
+    std::size_t ix = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true){
+        _changed.wait(lock, [&]{ return _stop || !_blocks[ix].full; });
+        if(_stop) return;
+
+        auto& block = _blocks[ix];
+        lock.unlock();
+        bool end = false;
+        std::size_t n = 0;
+        try{
+            n = _decoder->fill(block.data.data(), block.data.size(), end);
+        } catch(...){
+            lock.lock();
+            _error = std::current_exception();
+            end = true;
+            lock.unlock();
+        }
+        lock.lock();
+        block.size = n;
+        block.last = end;
+        block.full = true;
+        _changed.notify_all();
+        if(end) return;
+        ix ^= 1;
+    }
+}
+
+DecompressBuf::int_type DecompressBuf::underflow()
+{
+    if(gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true){
+        if(_holding){
+            // hand the drained block back to the worker
+            auto& block = _blocks[_current];
+            _done = block.last;
+            block.full = false;
+            _holding = false;
+            _current ^= 1;
+            _changed.notify_all();
+            setg(nullptr, nullptr, nullptr);
+        }
+        if(_done){
+            if(_error) std::rethrow_exception(_error);
+            return traits_type::eof();
+        }
+
+        _changed.wait(lock, [&]{ return _blocks[_current].full; });
+        auto& block = _blocks[_current];
+        _holding = true;
+        if(block.size){
+            setg(block.data.data(), block.data.data(), block.data.data() + block.size);
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+}
+
+DecompressStream::DecompressStream(std::istream& source, std::size_t blockSize)
+    : std::istream(nullptr), _buf(source, blockSize)
+{
+    rdbuf(&_buf);
+    // let decoding errors escape instead of looking like end of input
+    exceptions(std::ios::badbit);
+}
+
+} // ns
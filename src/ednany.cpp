@@ -20,10 +20,13 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <edncxx/ednany.h>
 #include <typeindex>
 #include <unordered_map>
+#include <vector>
 
 using namespace edncxx;
 
@@ -60,11 +63,246 @@ EdnType edntype(const ValueType& v)
 
 std::string typenameof(const ValueType& v)
 {
-    auto idx = static_cast<size_t>(edntype(v));
+    return typenameof(edntype(v));
+}
+
+std::string typenameof(EdnType type)
+{
+    auto idx = static_cast<size_t>(type);
     if(idx >= typeNames.size()) idx = 0;
     return typeNames[idx];
 }
 
+// hashof() and hash2of() run the same walk with independent mixers, seeds,
+// string hashes and memos, so together they give a 128 bit hash.
+namespace{
+    struct Lane1{
+        // murmur3's fmix64.  std::hash of an integer is often the integer itself,
+        // so every part is spread over the whole word before it is combined or summed
+        static std::size_t mix(std::size_t h)
+        {
+            std::uint64_t x = h;
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdull;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ull;
+            x ^= x >> 33;
+            return static_cast<std::size_t>(x);
+        }
+        static constexpr std::uint64_t golden = 0x9e3779b97f4a7c15ull;
+        static std::size_t seed(EdnType type) { return std::hash<int>()(type); }
+        static std::size_t str(const std::u32string& s) { return std::hash<std::u32string>()(s); }
+        static std::size_t real(FloatType f) { return std::hash<FloatType>()(f); }
+        template<typename Coll> static std::size_t cached(const Coll& c) { return c.cachedHash(); }
+        template<typename Coll> static void cache(const Coll& c, std::size_t h) { c.cacheHash(h); }
+    };
+
+    struct Lane2{
+        // splitmix64's finalizer
+        static std::size_t mix(std::size_t h)
+        {
+            std::uint64_t x = h;
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return static_cast<std::size_t>(x);
+        }
+        static constexpr std::uint64_t golden = 0x6a09e667f3bcc909ull;
+        static std::size_t seed(EdnType type) { return mix(type + 0x243f6a8885a308d3ull); }
+        // fnv-1a over code points
+        static std::size_t str(const std::u32string& s)
+        {
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            for(auto c : s){
+                h ^= c;
+                h *= 0x100000001b3ull;
+            }
+            return static_cast<std::size_t>(h);
+        }
+        // bit pattern, with -0.0 folded onto 0.0 as == does
+        static std::size_t real(FloatType f)
+        {
+            std::uint64_t bits = 0;
+            if(f != 0) std::memcpy(&bits, &f, sizeof bits);
+            return static_cast<std::size_t>(bits);
+        }
+        template<typename Coll> static std::size_t cached(const Coll& c) { return c.cachedHash2(); }
+        template<typename Coll> static void cache(const Coll& c, std::size_t h) { c.cacheHash2(h); }
+    };
+}
+
+template<typename Lane>
+static std::size_t combine(std::size_t seed, std::size_t h)
+{
+    return seed ^ (Lane::mix(h) + Lane::golden + (seed << 6) + (seed >> 2));
+}
+
+// collections keep their hash on the node, so rehashing a parent is shallow
+template<typename Lane, typename Coll, typename Fn>
+static std::size_t memoized(const Coll& coll, Fn compute)
+{
+    if(auto h = Lane::cached(coll)) return h;
+    auto h = compute();
+    if(!h) h = 1;
+    Lane::cache(coll, h);
+    return h;
+}
+
+// differing memos settle inequality without a walk
+template<typename Coll>
+static bool knownDifferent(const Coll& a, const Coll& b)
+{
+    auto ha = a.cachedHash(), hb = b.cachedHash();
+    auto ha2 = a.cachedHash2(), hb2 = b.cachedHash2();
+    return (ha && hb && ha != hb) || (ha2 && hb2 && ha2 != hb2) || a.size() != b.size();
+}
+
+template<typename Lane>
+static std::size_t hashWith(const ValueType& v);
+
+template<typename Lane, typename Seq>
+static std::size_t hashSeq(std::size_t seed, const Seq& seq)
+{
+    return memoized<Lane>(seq, [&]{
+        auto h = seed;
+        for(auto& item : seq)
+            h = combine<Lane>(h, hashWith<Lane>(item));
+        return h;
+    });
+}
+
+template<typename Seq>
+static bool equalSeq(const Seq& a, const Seq& b)
+{
+    if(a.shares(b)) return true;
+    if(knownDifferent(a, b)) return false;
+    for(auto ix = 0u; ix < a.size(); ++ix)
+        if(!equals(a[ix], b[ix])) return false;
+    return true;
+}
+
+template<typename Lane>
+static std::size_t hashWith(const ValueType& v)
+{
+    auto type = edntype(v);
+    auto seed = Lane::seed(type);
+    switch(type){
+        case T_Invalid:
+        case T_Nil:     return seed;
+        case T_Bool:    return combine<Lane>(seed, std::hash<BoolType>()(std::any_cast<const BoolType&>(v)));
+        case T_Char:    return combine<Lane>(seed, std::hash<CharType>()(std::any_cast<const CharType&>(v)));
+        case T_String:  return combine<Lane>(seed, Lane::str(std::any_cast<const StringType&>(v)));
+        case T_Integer: return combine<Lane>(seed, std::hash<IntegerType>()(std::any_cast<const IntegerType&>(v)));
+        case T_Float:   return combine<Lane>(seed, Lane::real(std::any_cast<const FloatType&>(v)));
+        case T_Keyword:{
+            auto& kw = std::any_cast<const KeywordType&>(v);
+            return combine<Lane>(combine<Lane>(seed, Lane::str(kw.ns)), Lane::str(kw.keyword));
+        }
+        case T_Symbol:{
+            auto& sym = std::any_cast<const SymbolType&>(v);
+            return combine<Lane>(combine<Lane>(seed, Lane::str(sym.ns)), Lane::str(sym.symbol));
+        }
+        case T_List:    return hashSeq<Lane>(seed, std::any_cast<const ListType&>(v));
+        case T_Vector:  return hashSeq<Lane>(seed, std::any_cast<const VectorType&>(v));
+        case T_Map:{
+            // order independent, same as equality
+            auto& map = std::any_cast<const MapType&>(v);
+            return memoized<Lane>(map, [&]{
+                std::size_t sum = 0;
+                for(auto& [key, value] : map)
+                    sum += Lane::mix(combine<Lane>(hashWith<Lane>(key), hashWith<Lane>(value)));
+                return combine<Lane>(seed, sum);
+            });
+        }
+        case T_Set:{
+            auto& set = std::any_cast<const SetType&>(v);
+            return memoized<Lane>(set, [&]{
+                std::size_t sum = 0;
+                for(auto& item : set)
+                    sum += Lane::mix(hashWith<Lane>(item));
+                return combine<Lane>(seed, sum);
+            });
+        }
+        case T_Tagged:{
+            auto& tagged = std::any_cast<const TaggedType&>(v);
+            return combine<Lane>(combine<Lane>(combine<Lane>(seed, Lane::str(tagged.ns)), Lane::str(tagged.tag)),
+                                 hashWith<Lane>(tagged.rep));
+        }
+        case T_Discard: return combine<Lane>(seed, hashWith<Lane>(std::any_cast<const DiscardType&>(v).discarded));
+    }
+    return seed;
+}
+
+std::size_t hashof(const ValueType& v)
+{
+    return hashWith<Lane1>(v);
+}
+
+std::size_t hash2of(const ValueType& v)
+{
+    return hashWith<Lane2>(v);
+}
+
+bool equals(const ValueType& a, const ValueType& b)
+{
+    auto type = edntype(a);
+    if(type != edntype(b)) return false;
+    switch(type){
+        case T_Invalid: return !a.has_value() && !b.has_value();
+        case T_Nil:     return true;
+        case T_Bool:    return std::any_cast<const BoolType&>(a) == std::any_cast<const BoolType&>(b);
+        case T_Char:    return std::any_cast<const CharType&>(a) == std::any_cast<const CharType&>(b);
+        case T_String:  return std::any_cast<const StringType&>(a) == std::any_cast<const StringType&>(b);
+        case T_Integer: return std::any_cast<const IntegerType&>(a) == std::any_cast<const IntegerType&>(b);
+        case T_Float:   return std::any_cast<const FloatType&>(a) == std::any_cast<const FloatType&>(b);
+        case T_Keyword:{
+            auto& x = std::any_cast<const KeywordType&>(a);
+            auto& y = std::any_cast<const KeywordType&>(b);
+            return x.ns == y.ns && x.keyword == y.keyword;
+        }
+        case T_Symbol:{
+            auto& x = std::any_cast<const SymbolType&>(a);
+            auto& y = std::any_cast<const SymbolType&>(b);
+            return x.ns == y.ns && x.symbol == y.symbol;
+        }
+        case T_List:    return equalSeq(std::any_cast<const ListType&>(a), std::any_cast<const ListType&>(b));
+        case T_Vector:  return equalSeq(std::any_cast<const VectorType&>(a), std::any_cast<const VectorType&>(b));
+        case T_Map:{
+            auto& x = std::any_cast<const MapType&>(a);
+            auto& y = std::any_cast<const MapType&>(b);
+            if(x.shares(y)) return true;
+            if(knownDifferent(x, y)) return false;
+            for(auto& [key, value] : x){
+                auto other = y.find(key);
+                if(!other || !equals(value, *other)) return false;
+            }
+            return true;
+        }
+        case T_Set:{
+            auto& x = std::any_cast<const SetType&>(a);
+            auto& y = std::any_cast<const SetType&>(b);
+            if(x.shares(y)) return true;
+            if(knownDifferent(x, y)) return false;
+            for(auto& item : x)
+                if(!y.contains(item)) return false;
+            return true;
+        }
+        case T_Tagged:{
+            auto& x = std::any_cast<const TaggedType&>(a);
+            auto& y = std::any_cast<const TaggedType&>(b);
+            return x.ns == y.ns && x.tag == y.tag && equals(x.rep, y.rep);
+        }
+        case T_Discard:
+            return equals(std::any_cast<const DiscardType&>(a).discarded, std::any_cast<const DiscardType&>(b).discarded);
+    }
+    return false;
+}
+
+std::size_t ValueHash::operator()(const ValueType& v) const { return hashof(v); }
+bool ValueEqual::operator()(const ValueType& a, const ValueType& b) const { return equals(a, b); }
+
 bool isNil(const ValueType& v){
     return std::any_cast<NilType>(&v);
 }
@@ -0,0 +1,159 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/edncolumnar.h>
+
+#include <unordered_map>
+
+using namespace edncxx;
+namespace edncxx{
+
+namespace{
+    using Index = std::unordered_map<ValueType, std::uint32_t, ValueHash, ValueEqual>;
+
+    // the narrowest column type that holds both
+    ColumnType widen(std::optional<ColumnType> seen, EdnType type)
+    {
+        ColumnType want;
+        switch(type){
+            case T_Bool:    want = ColumnType::Bool;    break;
+            case T_Integer: want = ColumnType::Integer; break;
+            case T_Float:   want = ColumnType::Float;   break;
+            case T_String:  want = ColumnType::String;  break;
+            case T_Keyword: want = ColumnType::Keyword; break;
+            default:        want = ColumnType::Value;   break;
+        }
+        return (!seen || *seen == want) ? want : ColumnType::Value;
+    }
+
+    template<typename Seq, typename Fn>
+    bool eachRow(const Seq& seq, Fn fn)
+    {
+        for(auto& row : seq){
+            if(!is<MapType>(row)) return false;
+            if(!fn(std::any_cast<const MapType&>(row))) return false;
+        }
+        return true;
+    }
+
+    template<typename Fn>
+    bool eachRow(const ValueType& rows, Fn fn)
+    {
+        if(is<VectorType>(rows)) return eachRow(std::any_cast<const VectorType&>(rows), fn);
+        if(is<ListType>(rows)) return eachRow(std::any_cast<const ListType&>(rows), fn);
+        return false;
+    }
+}
+
+ValueType Column::at(std::size_t row) const
+{
+    if(isNull(row)) return NilType{};
+    switch(type){
+        case ColumnType::Bool:    return BoolType{bools[row] != 0};
+        case ColumnType::Integer: return integers[row];
+        case ColumnType::Float:   return floats[row];
+        case ColumnType::String:
+        case ColumnType::Keyword: return dictionary[codes[row]];
+        case ColumnType::Value:   return values[row];
+    }
+    return NilType{};
+}
+
+const Column* ColumnarTable::column(const KeywordType& name) const
+{
+    for(auto& col : columns)
+        if(col.name.ns == name.ns && col.name.keyword == name.keyword) return &col;
+    return nullptr;
+}
+
+std::optional<ColumnarTable> toColumnar(const ValueType& rows)
+{
+    // first pass: which keys, of which types
+    Index keys;
+    std::vector<std::optional<ColumnType>> types;
+    ColumnarTable table;
+    bool tabular = eachRow(rows, [&](const MapType& row){
+        for(auto& [key, value] : row){
+            if(!is<KeywordType>(key)) return false;
+            auto found = keys.try_emplace(key, static_cast<std::uint32_t>(types.size()));
+            if(found.second){
+                types.emplace_back();
+                Column col;
+                col.name = std::any_cast<const KeywordType&>(key);
+                table.columns.push_back(std::move(col));
+            }
+            if(!is<NilType>(value)){
+                auto& t = types[found.first->second];
+                t = widen(t, edntype(value));
+            }
+        }
+        ++table.rows;
+        return true;
+    });
+    if(!tabular) return std::nullopt;
+
+    auto n = table.rows;
+    std::vector<Index> dictionaries(table.columns.size());
+    for(auto ix = 0u; ix < table.columns.size(); ++ix){
+        auto& col = table.columns[ix];
+        col.type = types[ix].value_or(ColumnType::Value);
+        col.valid.assign((n + 63) / 64, 0);
+        switch(col.type){
+            case ColumnType::Bool:    col.bools.assign(n, 0); break;
+            case ColumnType::Integer: col.integers.assign(n, 0); break;
+            case ColumnType::Float:   col.floats.assign(n, 0.0); break;
+            case ColumnType::String:
+            case ColumnType::Keyword: col.codes.assign(n, 0); break;
+            case ColumnType::Value:   col.values.assign(n, NilType{}); break;
+        }
+    }
+
+    // second pass: scatter each row's entries into their columns
+    std::size_t row = 0;
+    eachRow(rows, [&](const MapType& entries){
+        for(auto& [key, value] : entries){
+            if(is<NilType>(value)) continue;
+            auto ix = keys.find(key)->second;
+            auto& col = table.columns[ix];
+            col.valid[row / 64] |= std::uint64_t(1) << (row % 64);
+            switch(col.type){
+                case ColumnType::Bool:    col.bools[row] = std::any_cast<BoolType>(value); break;
+                case ColumnType::Integer: col.integers[row] = std::any_cast<IntegerType>(value); break;
+                case ColumnType::Float:   col.floats[row] = std::any_cast<FloatType>(value); break;
+                case ColumnType::String:
+                case ColumnType::Keyword:{
+                    auto code = dictionaries[ix].try_emplace(value, static_cast<std::uint32_t>(col.dictionary.size()));
+                    if(code.second) col.dictionary.push_back(value);
+                    col.codes[row] = code.first->second;
+                    break;
+                }
+                case ColumnType::Value:   col.values[row] = value; break;
+            }
+        }
+        ++row;
+        return true;
+    });
+    return table;
+}
+
+} // ns
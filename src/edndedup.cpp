@@ -0,0 +1,207 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <cstring>
+#include <edncxx/edndedup.h>
+
+using namespace edncxx;
+namespace edncxx{
+
+static bool isCollection(EdnType type)
+{
+    return type == T_List || type == T_Vector || type == T_Map || type == T_Set;
+}
+
+static std::size_t stringBytes(const std::u32string& s)
+{
+    // libstdc++ keeps up to 3 char32_t in place
+    return s.capacity() > 3 ? (s.capacity() + 1) * sizeof(char32_t) : 0;
+}
+
+// heap held by a value that is not shared through a node: std::any boxes
+// anything wider than a pointer, strings add their buffer
+static std::size_t leafBytes(const ValueType& v)
+{
+    switch(edntype(v)){
+        case T_String:  return sizeof(StringType) + stringBytes(std::any_cast<const StringType&>(v));
+        case T_Keyword:{
+            auto& kw = std::any_cast<const KeywordType&>(v);
+            return sizeof(KeywordType) + stringBytes(kw.ns) + stringBytes(kw.keyword);
+        }
+        case T_Symbol:{
+            auto& sym = std::any_cast<const SymbolType&>(v);
+            return sizeof(SymbolType) + stringBytes(sym.ns) + stringBytes(sym.symbol);
+        }
+        case T_Tagged:  return sizeof(TaggedType);
+        case T_Discard: return sizeof(DiscardType);
+        default:        return 0;
+    }
+}
+
+template<typename Seq>
+static std::size_t seqBytes(const Seq& seq)
+{
+    auto bytes = seq.allocated();
+    for(auto& item : seq) bytes += leafBytes(item);
+    return bytes;
+}
+
+// what dropping this duplicate frees: its node plus unshared leaves,
+// collections below it are already canonical and stay alive
+static std::size_t droppedBytes(const ValueType& v)
+{
+    switch(edntype(v)){
+        case T_List:   return seqBytes(std::any_cast<const ListType&>(v));
+        case T_Vector: return seqBytes(std::any_cast<const VectorType&>(v));
+        case T_Set:    return seqBytes(std::any_cast<const SetType&>(v));
+        case T_Map:{
+            auto& map = std::any_cast<const MapType&>(v);
+            auto bytes = map.allocated();
+            for(auto& [key, value] : map) bytes += leafBytes(key) + leafBytes(value);
+            return bytes;
+        }
+        default:       return 0;
+    }
+}
+
+static std::size_t useCount(const ValueType& v)
+{
+    switch(edntype(v)){
+        case T_List:   return std::any_cast<const ListType&>(v).useCount();
+        case T_Vector: return std::any_cast<const VectorType&>(v).useCount();
+        case T_Map:    return std::any_cast<const MapType&>(v).useCount();
+        case T_Set:    return std::any_cast<const SetType&>(v).useCount();
+        default:       return 0;
+    }
+}
+
+static bool identical(const ValueType& a, const ValueType& b);
+
+template<typename Seq>
+static bool identicalSeq(const Seq& a, const Seq& b)
+{
+    if(a.shares(b)) return true;
+    if(a.size() != b.size()) return false;
+    for(auto ix = 0u; ix < a.size(); ++ix)
+        if(!identical(a[ix], b[ix])) return false;
+    return true;
+}
+
+static bool identicalEntry(const ValueType& a, const ValueType& b) { return identical(a, b); }
+
+template<typename K, typename V>
+static bool identicalEntry(const std::pair<K,V>& a, const std::pair<K,V>& b)
+{
+    return identical(a.first, b.first) && identical(a.second, b.second);
+}
+
+// entries are matched in place first, which is how equal text reads back,
+// then by key.  a NaN key is never found by key, so such a map only
+// matches one in the same order.
+template<typename Table, typename KeyOf>
+static bool identicalTable(const Table& a, const Table& b, KeyOf keyOf)
+{
+    if(a.shares(b)) return true;
+    if(a.size() != b.size() || hashof(a) != hashof(b)) return false;
+    for(auto ix = 0u; ix < a.size(); ++ix){
+        auto& entry = a.begin()[ix];
+        if(identicalEntry(entry, b.begin()[ix])) continue;
+        auto other = b.findEntry(keyOf(entry));
+        if(!other || !identicalEntry(entry, *other)) return false;
+    }
+    return true;
+}
+
+static bool identical(const ValueType& a, const ValueType& b)
+{
+    auto type = edntype(a);
+    if(type != edntype(b)) return false;
+    switch(type){
+        case T_Float:{
+            auto x = std::any_cast<FloatType>(a), y = std::any_cast<FloatType>(b);
+            return std::memcmp(&x, &y, sizeof x) == 0;
+        }
+        case T_List:    return identicalSeq(std::any_cast<const ListType&>(a), std::any_cast<const ListType&>(b));
+        case T_Vector:  return identicalSeq(std::any_cast<const VectorType&>(a), std::any_cast<const VectorType&>(b));
+        case T_Map:
+            return identicalTable(std::any_cast<const MapType&>(a), std::any_cast<const MapType&>(b),
+                                  [](const MapType::value_type& e) -> const ValueType& { return e.first; });
+        case T_Set:
+            return identicalTable(std::any_cast<const SetType&>(a), std::any_cast<const SetType&>(b),
+                                  [](const ValueType& e) -> const ValueType& { return e; });
+        case T_Tagged:{
+            auto& x = std::any_cast<const TaggedType&>(a);
+            auto& y = std::any_cast<const TaggedType&>(b);
+            return x.ns == y.ns && x.tag == y.tag && identical(x.rep, y.rep);
+        }
+        case T_Discard:
+            return identical(std::any_cast<const DiscardType&>(a).discarded, std::any_cast<const DiscardType&>(b).discarded);
+        default:        return equals(a, b);
+    }
+}
+
+// std::hash<double> hashes the bits, folding -0.0 onto 0.0 only, so values
+// identical bit for bit always agree on hashof()
+std::size_t DedupTable::SameHash::operator()(const ValueType& v) const { return hashof(v); }
+bool DedupTable::SameValue::operator()(const ValueType& a, const ValueType& b) const { return identical(a, b); }
+
+ValueType DedupTable::intern(ValueType v)
+{
+    if(!isCollection(edntype(v)))
+        return v;
+
+    auto found = _values.find(v);
+    if(found != _values.end()){
+        ++_hits;
+        _bytesSaved += droppedBytes(v);
+        return *found;
+    }
+    _values.insert(v);
+    return v;
+}
+
+void DedupTable::prune()
+{
+    // dropping a parent can orphan its children, go until nothing changes
+    bool erased = true;
+    while(erased){
+        erased = false;
+        for(auto it = _values.begin(); it != _values.end();){
+            if(useCount(*it) <= 1){
+                it = _values.erase(it);
+                erased = true;
+            }
+            else
+                ++it;
+        }
+    }
+}
+
+void DedupTable::clear()
+{
+    _values.clear();
+    _hits = 0;
+    _bytesSaved = 0;
+}
+
+} // ns
@@ -0,0 +1,211 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/edndiff.h>
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+using namespace edncxx;
+namespace edncxx{
+
+namespace{
+    using Path = std::vector<ValueType>;
+
+    // one pending step of the walk: compare a with b, or report a lone value
+    struct Item{
+        enum Kind{ Compare, Added, Removed };
+        Kind kind;
+        const ValueType* a;             // before, or the lone value
+        const ValueType* b;
+        std::size_t depth;              // path length of the parent
+        ValueType step;                 // key or index below the parent, empty for none
+    };
+
+    class Differ{
+    public:
+        explicit Differ(const DiffOptions& opts) : _opts(opts) {}
+
+        // the walk is iterative, items are popped from the back of stack
+        void walk(std::vector<Item>& stack, Path& path, std::vector<Change>& out, bool parallel) const;
+
+    private:
+        bool same(const ValueType& a, const ValueType& b) const;
+        bool expand(const ValueType& a, const ValueType& b, std::size_t depth, std::vector<Item>& children) const;
+        void fanOut(std::vector<Item>& children, const Path& path, std::vector<Change>& out) const;
+
+        const DiffOptions& _opts;
+    };
+
+    template<typename Coll>
+    bool sharesNode(const ValueType& a, const ValueType& b)
+    {
+        return std::any_cast<const Coll&>(a).shares(std::any_cast<const Coll&>(b));
+    }
+
+    template<typename Seq>
+    void expandSeq(const Seq& a, const Seq& b, std::size_t depth, std::vector<Item>& children)
+    {
+        auto common = std::min(a.size(), b.size());
+        for(std::size_t ix = 0; ix < common; ++ix)
+            children.push_back({Item::Compare, &a.begin()[ix], &b.begin()[ix], depth, IntegerType(ix)});
+        for(auto ix = common; ix < a.size(); ++ix)
+            children.push_back({Item::Removed, &a.begin()[ix], nullptr, depth, IntegerType(ix)});
+        for(auto ix = common; ix < b.size(); ++ix)
+            children.push_back({Item::Added, &b.begin()[ix], nullptr, depth, IntegerType(ix)});
+    }
+}
+
+bool Differ::same(const ValueType& a, const ValueType& b) const
+{
+    auto type = edntype(a);
+    if(type != edntype(b)) return false;
+    switch(type){
+        case T_List:    if(sharesNode<ListType>(a, b)) return true;   break;
+        case T_Vector:  if(sharesNode<VectorType>(a, b)) return true; break;
+        case T_Map:     if(sharesNode<MapType>(a, b)) return true;    break;
+        case T_Set:     if(sharesNode<SetType>(a, b)) return true;    break;
+        case T_Tagged:  break;
+        default:        return equals(a, b);
+    }
+    // memoized on the nodes, so only the first look at a subtree walks it.
+    // a match on both hashes is taken as equal unless asked to confirm
+    if(hashof(a) != hashof(b) || hash2of(a) != hash2of(b)) return false;
+    return !_opts.verify || equals(a, b);
+}
+
+// the children of two differing values, false when they differ as a whole
+bool Differ::expand(const ValueType& a, const ValueType& b, std::size_t depth, std::vector<Item>& children) const
+{
+    auto type = edntype(a);
+    if(type != edntype(b)) return false;
+    switch(type){
+        case T_List:
+            expandSeq(std::any_cast<const ListType&>(a), std::any_cast<const ListType&>(b), depth, children);
+            return true;
+        case T_Vector:
+            expandSeq(std::any_cast<const VectorType&>(a), std::any_cast<const VectorType&>(b), depth, children);
+            return true;
+        case T_Map:{
+            auto& x = std::any_cast<const MapType&>(a);
+            auto& y = std::any_cast<const MapType&>(b);
+            for(auto& [key, value] : x){
+                if(auto other = y.find(key))
+                    children.push_back({Item::Compare, &value, other, depth, key});
+                else
+                    children.push_back({Item::Removed, &value, nullptr, depth, key});
+            }
+            for(auto& [key, value] : y)
+                if(!x.contains(key))
+                    children.push_back({Item::Added, &value, nullptr, depth, key});
+            return true;
+        }
+        case T_Set:{
+            auto& x = std::any_cast<const SetType&>(a);
+            auto& y = std::any_cast<const SetType&>(b);
+            for(auto& item : x)
+                if(!y.contains(item))
+                    children.push_back({Item::Removed, &item, nullptr, depth, {}});
+            for(auto& item : y)
+                if(!x.contains(item))
+                    children.push_back({Item::Added, &item, nullptr, depth, {}});
+            return true;
+        }
+        case T_Tagged:{
+            auto& x = std::any_cast<const TaggedType&>(a);
+            auto& y = std::any_cast<const TaggedType&>(b);
+            if(x.ns != y.ns || x.tag != y.tag) return false;
+            children.push_back({Item::Compare, &x.rep, &y.rep, depth, {}});
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// children compared in contiguous runs, one task per run, results kept in order
+void Differ::fanOut(std::vector<Item>& children, const Path& path, std::vector<Change>& out) const
+{
+    std::size_t tasks = std::max(1u, std::thread::hardware_concurrency());
+    auto run = (children.size() + tasks - 1) / tasks;
+    std::vector<std::future<std::vector<Change>>> parts;
+    for(std::size_t lo = 0; lo < children.size(); lo += run){
+        auto hi = std::min(children.size(), lo + run);
+        parts.push_back(std::async(std::launch::async, [this, &children, &path, lo, hi]{
+            std::vector<Item> stack;
+            stack.reserve(hi - lo);
+            for(auto ix = hi; ix > lo; --ix)
+                stack.push_back(std::move(children[ix - 1]));
+            Path local = path;
+            std::vector<Change> part;
+            walk(stack, local, part, false);
+            return part;
+        }));
+    }
+    for(auto& part : parts){
+        auto changes = part.get();
+        std::move(changes.begin(), changes.end(), std::back_inserter(out));
+    }
+}
+
+void Differ::walk(std::vector<Item>& stack, Path& path, std::vector<Change>& out, bool parallel) const
+{
+    std::vector<Item> children;
+    while(!stack.empty()){
+        auto item = std::move(stack.back());
+        stack.pop_back();
+        path.resize(item.depth);
+        if(item.step.has_value())
+            path.push_back(std::move(item.step));
+
+        switch(item.kind){
+            case Item::Added:   out.push_back({Change::Added, path, {}, *item.a});   continue;
+            case Item::Removed: out.push_back({Change::Removed, path, *item.a, {}}); continue;
+            case Item::Compare: break;
+        }
+        if(same(*item.a, *item.b)) continue;
+
+        children.clear();
+        if(!expand(*item.a, *item.b, path.size(), children)){
+            out.push_back({Change::Changed, path, *item.a, *item.b});
+            continue;
+        }
+        if(parallel && _opts.parallelThreshold && children.size() >= _opts.parallelThreshold)
+            fanOut(children, path, out);
+        else
+            std::move(children.rbegin(), children.rend(), std::back_inserter(stack));
+    }
+}
+
+std::vector<Change> diff(const ValueType& before, const ValueType& after, const DiffOptions& options)
+{
+    std::vector<Item> stack;
+    stack.push_back({Item::Compare, &before, &after, 0, {}});
+    Path path;
+    std::vector<Change> out;
+    Differ(options).walk(stack, path, out, true);
+    return out;
+}
+
+} // ns
@@ -0,0 +1,261 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/ednfootprint.h>
+
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+using namespace edncxx;
+namespace edncxx{
+
+TypeFootprint& TypeFootprint::operator+=(const TypeFootprint& other)
+{
+    count += other.count;
+    payload += other.payload;
+    overhead += other.overhead;
+    slack += other.slack;
+    allocations += other.allocations;
+    return *this;
+}
+
+TypeFootprint Footprint::total() const
+{
+    TypeFootprint sum;
+    for(auto& t : types) sum += t;
+    return sum;
+}
+
+// same rule libstdc++ uses to keep a value inside std::any itself
+template<typename T>
+static constexpr bool boxed()
+{
+    return !(sizeof(T) <= sizeof(void*) && alignof(void*) % alignof(T) == 0 &&
+             std::is_nothrow_move_constructible_v<T>);
+}
+
+namespace{
+    // sampling leaves weights fractional, so tally in doubles and round at the end
+    struct Tally{
+        double count = 0, payload = 0, overhead = 0, slack = 0, allocations = 0;
+    };
+
+    // libstdc++ keeps up to 3 char32_t inside the string object
+    const std::size_t LocalChars = 15 / sizeof(char32_t);
+    const std::size_t SampleFloor = 32;
+
+    struct Item{
+        const ValueType* value;
+        double weight;
+        bool inSlot;
+    };
+
+    class Walker{
+    public:
+        explicit Walker(double rate) : _stride(rate >= 1.0 ? 1 : static_cast<std::size_t>(std::ceil(1.0 / rate))) {}
+
+        Footprint run(const ValueType& root){
+            _stack.push_back({&root, 1.0, false});
+            while(!_stack.empty()){
+                auto item = _stack.back();
+                _stack.pop_back();
+                visit(item);
+            }
+            Footprint result;
+            result.sampled = _sampled;
+            for(auto ix = 0u; ix <= T_Discard; ++ix){
+                auto& t = _tallies[ix];
+                auto& out = result.types[ix];
+                out.count = static_cast<std::size_t>(std::llround(t.count));
+                out.payload = static_cast<std::size_t>(std::llround(t.payload));
+                out.overhead = static_cast<std::size_t>(std::llround(t.overhead));
+                out.slack = static_cast<std::size_t>(std::llround(t.slack));
+                out.allocations = static_cast<std::size_t>(std::llround(t.allocations));
+            }
+            return result;
+        }
+
+    private:
+        // charges a value's bytes: total, of which payload and slack, rest is overhead
+        void charge(EdnType type, double weight, double total, double payload, double slack, double allocations){
+            auto& t = _tallies[type];
+            t.count += weight;
+            t.payload += weight * payload;
+            t.slack += weight * slack;
+            t.overhead += weight * (total - payload - slack);
+            t.allocations += weight * allocations;
+        }
+
+        // a string member: characters are payload wherever they live,
+        // a heap buffer adds its spare capacity and the terminator
+        struct Str{ double total = 0, payload = 0, slack = 0, allocations = 0; };
+        static void addString(Str& s, const std::u32string& str){
+            s.payload += str.size() * sizeof(char32_t);
+            if(str.capacity() > LocalChars){
+                s.total += (str.capacity() + 1) * sizeof(char32_t);
+                s.slack += (str.capacity() - str.size()) * sizeof(char32_t);
+                ++s.allocations;
+            }
+        }
+
+        template<typename T>
+        void chargeScalar(const Item& item, EdnType type){
+            double slot = item.inSlot ? sizeof(ValueType) : 0;
+            if(boxed<T>())
+                charge(type, item.weight, slot + sizeof(T), 0, 0, 1);
+            else
+                charge(type, item.weight, slot, item.inSlot ? sizeof(T) : 0, 0, 0);
+        }
+
+        template<typename T>
+        void chargeText(const Item& item, EdnType type, std::initializer_list<const std::u32string*> strings){
+            Str s;
+            s.total = (item.inSlot ? sizeof(ValueType) : 0) + sizeof(T);
+            s.allocations = 1;
+            for(auto str : strings) addString(s, *str);
+            charge(type, item.weight, s.total, s.payload, s.slack, s.allocations);
+        }
+
+        void push(const ValueType& v, double weight){ _stack.push_back({&v, weight, true}); }
+
+        // the handle sits in the slot, node header, spare capacity and index are the collection's
+        template<typename Coll, typename Each>
+        void chargeCollection(const Item& item, EdnType type, const Coll& coll, Each each){
+            double slot = item.inSlot ? sizeof(ValueType) : 0;
+            if(!coll.identity() || !_seen.insert(coll.identity()).second){
+                charge(type, item.weight, slot, 0, 0, 0);
+                return;
+            }
+            using Elem = typename Coll::value_type;
+            double spare = (coll.capacity() - coll.size()) * sizeof(Elem);
+            double total = slot + Coll::headerBytes() + spare + coll.indexBytes();
+            charge(type, item.weight, total, 0, spare, coll.indexBytes() ? 2 : 1);
+
+            auto n = coll.size();
+            auto stride = n > SampleFloor ? _stride : 1;
+            if(stride > 1) _sampled = true;
+            std::size_t walked = (n + stride - 1) / stride;
+            double weight = item.weight * (walked ? double(n) / walked : 1.0);
+            for(std::size_t ix = 0; ix < n; ix += stride)
+                each(coll.begin()[ix], weight);
+        }
+
+        void visit(const Item& item){
+            auto& v = *item.value;
+            auto type = edntype(v);
+            auto elem = [&](const ValueType& child, double weight){ push(child, weight); };
+            switch(type){
+                case T_Invalid: charge(type, item.weight, item.inSlot ? sizeof(ValueType) : 0, 0, 0, 0); break;
+                case T_Nil:     chargeScalar<NilType>(item, type); break;
+                case T_Bool:    chargeScalar<BoolType>(item, type); break;
+                case T_Char:    chargeScalar<CharType>(item, type); break;
+                case T_Integer: chargeScalar<IntegerType>(item, type); break;
+                case T_Float:   chargeScalar<FloatType>(item, type); break;
+                case T_String:{
+                    auto& str = std::any_cast<const StringType&>(v);
+                    chargeText<StringType>(item, type, {&str});
+                    break;
+                }
+                case T_Keyword:{
+                    auto& kw = std::any_cast<const KeywordType&>(v);
+                    chargeText<KeywordType>(item, type, {&kw.ns, &kw.keyword});
+                    break;
+                }
+                case T_Symbol:{
+                    auto& sym = std::any_cast<const SymbolType&>(v);
+                    chargeText<SymbolType>(item, type, {&sym.ns, &sym.symbol});
+                    break;
+                }
+                case T_Tagged:{
+                    // the rep's slot lives in the box and is charged to the rep
+                    auto& tagged = std::any_cast<const TaggedType&>(v);
+                    Str s;
+                    s.total = (item.inSlot ? sizeof(ValueType) : 0) + sizeof(TaggedType) - sizeof(ValueType);
+                    s.allocations = 1;
+                    addString(s, tagged.ns);
+                    addString(s, tagged.tag);
+                    charge(type, item.weight, s.total, s.payload, s.slack, s.allocations);
+                    push(tagged.rep, item.weight);
+                    break;
+                }
+                case T_Discard:{
+                    auto& discard = std::any_cast<const DiscardType&>(v);
+                    double total = (item.inSlot ? sizeof(ValueType) : 0) + sizeof(DiscardType) - sizeof(ValueType);
+                    charge(type, item.weight, total, 0, 0, boxed<DiscardType>() ? 1 : 0);
+                    push(discard.discarded, item.weight);
+                    break;
+                }
+                case T_List:   chargeCollection(item, type, std::any_cast<const ListType&>(v), elem); break;
+                case T_Vector: chargeCollection(item, type, std::any_cast<const VectorType&>(v), elem); break;
+                case T_Set:    chargeCollection(item, type, std::any_cast<const SetType&>(v), elem); break;
+                case T_Map:
+                    chargeCollection(item, type, std::any_cast<const MapType&>(v),
+                        [&](const std::pair<ValueType, ValueType>& entry, double weight){
+                            push(entry.first, weight);
+                            push(entry.second, weight);
+                        });
+                    break;
+            }
+        }
+
+        std::size_t _stride;
+        bool _sampled = false;
+        Tally _tallies[T_Discard + 1];
+        std::vector<Item> _stack;
+        std::unordered_set<const void*> _seen;
+    };
+}
+
+Footprint footprint(const ValueType& root)
+{
+    return Walker(1.0).run(root);
+}
+
+Footprint footprint(const ValueType& root, double sampleRate)
+{
+    if(!(sampleRate > 0.0)) sampleRate = 1.0;
+    return Walker(sampleRate).run(root);
+}
+
+std::ostream& operator<<(std::ostream& os, const Footprint& fp)
+{
+    auto line = [&](const std::string& name, const TypeFootprint& t){
+        os << std::left << std::setw(8) << name << std::right
+           << " count: " << std::setw(10) << t.count
+           << " bytes: " << std::setw(12) << t.bytes()
+           << " payload: " << std::setw(12) << t.payload
+           << " overhead: " << std::setw(12) << t.overhead
+           << " slack: " << std::setw(10) << t.slack
+           << " allocs: " << std::setw(10) << t.allocations << '\n';
+    };
+    for(auto ix = 0u; ix <= T_Discard; ++ix)
+        if(fp.types[ix].count) line(typenameof(static_cast<EdnType>(ix)), fp.types[ix]);
+    line(fp.sampled ? "~Total" : "Total", fp.total());
+    return os;
+}
+
+} // ns
@@ -0,0 +1,116 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/ednincremental.h>
+#include <edncxx/utf8reader.h>
+
+#include <algorithm>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
+
+using namespace edncxx;
+namespace edncxx{
+
+namespace{
+    // reads straight out of the document text, no copy of the tail
+    class ViewBuf : public std::streambuf{
+    public:
+        explicit ViewBuf(std::string_view text){
+            auto p = const_cast<char*>(text.data());
+            setg(p, p, p + text.size());
+        }
+    };
+}
+
+IncrementalDocument::IncrementalDocument(std::string text, ReadOptions options)
+    : _text(std::move(text)), _options(options)
+{
+    reparse(0, 0, 0, 0);
+}
+
+void IncrementalDocument::edit(std::size_t offset, std::size_t removed, std::string_view inserted)
+{
+    if(offset > _text.size() || removed > _text.size() - offset)
+        throw std::out_of_range("IncrementalDocument::edit outside the text");
+    _text.replace(offset, removed, inserted);
+
+    if(_stale){
+        _forms.clear();
+        reparse(0, 0, 0, 0);
+        return;
+    }
+
+    // first form that could have been touched: one ending exactly at the
+    // edit is included, the edit may extend its last token
+    auto first = static_cast<std::size_t>(std::partition_point(_forms.begin(), _forms.end(),
+        [&](const Form& f){ return f.end < offset; }) - _forms.begin());
+    auto start = first < _forms.size() ? _forms[first].begin : (_forms.empty() ? 0 : _forms.back().end);
+    start = std::min(start, offset);
+    auto delta = static_cast<std::ptrdiff_t>(inserted.size()) - static_cast<std::ptrdiff_t>(removed);
+    reparse(start, offset + inserted.size(), delta, first);
+}
+
+// re-reads from `start` (new text) replacing old forms from index `first`,
+// until a form boundary past `editEnd` lines up with an old form's start
+void IncrementalDocument::reparse(std::size_t start, std::size_t editEnd, std::ptrdiff_t delta, std::size_t first)
+{
+    std::vector<Form> fresh;
+    auto old = first;
+    ViewBuf buf(std::string_view(_text).substr(start));
+    std::istream strm(&buf);
+    Utf8Reader rdr(strm);
+    bool resynced = false;
+    try{
+        while(true){
+            auto pos = start + rdr.offset();
+            if(pos >= editEnd){
+                auto oldPos = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(pos) - delta);
+                while(old < _forms.size() && _forms[old].begin < oldPos) ++old;
+                if(old < _forms.size() && _forms[old].begin == oldPos){
+                    resynced = true;
+                    break;
+                }
+            }
+            auto value = readValue(rdr, _options);
+            if(!value) break;
+            fresh.push_back({pos, start + rdr.offset(), std::move(*value)});
+        }
+    } catch(...){
+        _stale = true;
+        throw;
+    }
+    _stale = false;
+    _lastReparsed = fresh.size();
+
+    // splice: untouched head, fresh middle, shifted tail
+    auto tail = resynced ? old : _forms.size();
+    for(auto ix = tail; ix < _forms.size(); ++ix){
+        _forms[ix].begin += delta;
+        _forms[ix].end += delta;
+    }
+    auto at = _forms.erase(_forms.begin() + first, _forms.begin() + tail);
+    _forms.insert(at, std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+}
+
+} // ns
@@ -28,8 +28,12 @@
 #include <sstream>
 #include <stdexcept>
 #include <optional>
+#include <vector>
 
 #include <edncxx/ednany.h>
+#include <edncxx/edndedup.h>
+#include <edncxx/ednschema.h>
+#include <edncxx/utf8cvt.h>
 
 using namespace edncxx;
 using namespace std;
@@ -65,6 +69,16 @@ static void eatcomment(Utf8Reader& r)
     r.getUntil([](char32_t ch){ return (ch == U'\n'); });
 }
 
+// whitespace and comments between forms
+static void skipws(Utf8Reader& r)
+{
+    while(true){
+        r.getWhile(iswhitespace);
+        if(r.peek() != U';') break;
+        eatcomment(r);
+    }
+}
+
 static void boom(const std::string_view& what) 
 {
     std::ostringstream msg;
@@ -90,8 +104,16 @@ static bool tokenmatch(Utf8Reader& r, const std::string_view& text)
     return true;
 }
 
-// forward
-std::optional<edncxx::ValueType> readValue(Utf8Reader& r);
+// completed collections go through the dedup table, if there is one.
+// children are hashed before their parent, so hashing here is shallow.
+static ValueType finish(const ReadOptions& opts, ValueType v)
+{
+    if(opts.hash){
+        hashof(v);
+        hash2of(v);
+    }
+    return opts.dedup ? opts.dedup->intern(std::move(v)) : v;
+}
 
 static ValueType readString(Utf8Reader& rdr)
 {
@@ -103,6 +125,8 @@ static ValueType readString(Utf8Reader& rdr)
     }
     while(true){
         auto ch = rdr.get();
+        if(ch == char32_t(-1))
+            throw std::runtime_error("EOF while reading String");
         if(in_escape){
             
             auto ach = 0;
@@ -150,114 +174,450 @@ static ValueType readSymbol(Utf8Reader&)
     return {};
 }
 
-static ValueType readList(Utf8Reader&)
+static std::optional<ValueType> readNil(Utf8Reader& r)
 {
-    boom("readList");
-    return {};
+    if(tokenmatch(r, "nil")){
+        return NilType();
+    }
+    return std::nullopt;
 }
 
-static ValueType readVector(Utf8Reader&)
+static std::optional<ValueType> readBool(Utf8Reader& r)
 {
-    boom("readVector");
-    return {};
+    if(tokenmatch(r, "true")) return BoolType{ true };
+    if(tokenmatch(r, "false")) return BoolType{ false };
+    return std::nullopt;
 }
 
-static ValueType readMap(Utf8Reader&)
+static std::optional<ValueType> readInteger(Utf8Reader&)
 {
-    boom("readMap");
+    boom("readInteger");
     return {};
 }
 
-static std::optional<ValueType> readSet(Utf8Reader&)
+static std::optional<ValueType> readFloat(Utf8Reader& r)
 {
-    boom("readSet");
+    // auto buf = r.getUntil(r, isterminator);
+    boom("readFloat");
     return {};
 }
 
-static std::optional<ValueType> readTagged(Utf8Reader&)
+std::optional<ValueType> readValue(Utf8Reader& r)
 {
-    boom("readTagged");
-    return {};
+    return readValue(r, ReadOptions{});
 }
 
-static std::optional<ValueType> readDiscard(Utf8Reader&)
+// everything that is not a collection, tag or discard.  kind is set to
+// the type read, which spares callers an edntype() lookup.
+static ValueType readScalar(Utf8Reader& r, EdnType& kind)
 {
-    boom("readDiscard");
-    return {};
+    const auto& loc = r.loc();
+    std::optional<ValueType> result;
+    switch(r.peek()){
+        case U'"':     result = readString(r);   kind = T_String;  break;
+        case U'\'':    result = readChar(r);     kind = T_Char;    break;
+        case U':':     result = readKeyword(r);  kind = T_Keyword; break;
+        default:{
+            if((result = readNil(r)))     { kind = T_Nil;     break; }
+            if((result = readBool(r)))    { kind = T_Bool;    break; }
+            if((result = readInteger(r))) { kind = T_Integer; break; }
+            if((result = readFloat(r)))   { kind = T_Float;   break; }
+            if((result = readSymbol(r)))  { kind = T_Symbol;  break; }
+        }
+    }
+    if(!result){
+        std::ostringstream msg;
+        msg << "Unable to recognize EDN @ line: " << loc.first << " col: " << loc.second;
+        throw std::runtime_error(msg.str());
+    }
+    return std::move(*result);
 }
 
-static std::optional<ValueType> readNil(Utf8Reader& r)
+// containers are read without recursion: every open collection, tag or
+// discard is a Frame on an explicit stack, and elements wait on a shared
+// value stack until their collection closes.  the stacks belong to the
+// thread and keep their capacity from one call to the next.
+namespace{
+    struct Frame{
+        explicit Frame(EdnType kind) : kind(kind) {}
+
+        EdnType kind;               // T_List, T_Vector, T_Map, T_Set, T_Tagged or T_Discard
+        std::size_t base = 0;       // first element on the value stack
+        std::u32string ns, tag;     // T_Tagged only
+        std::size_t begin = 0;      // byte offset of the opening delimiter or #
+        Schema::Ref schema = 0;     // what the frame must match, for T_Tagged its rep
+        Schema::Ref pending = 0;    // record: schema of the value after the last key
+        std::uint32_t required = 0; // record: required keys seen so far
+        std::size_t seen = 0;       // record: its first flag in ParseStack::seen
+    };
+
+    struct ParseStack{
+        std::vector<Frame> frames;
+        std::vector<ValueType> values;
+        std::vector<std::uint8_t> seen;     // per field of each open record, set once its key is read
+        bool busy = false;
+    };
+    thread_local ParseStack threadStack;
+
+    // borrows the thread's stacks, or private ones if they are already in use
+    class StackLease{
+    public:
+        StackLease() : _stack(threadStack.busy ? _own : threadStack) { _stack.busy = true; }
+        ~StackLease(){
+            _stack.frames.clear();
+            _stack.values.clear();
+            _stack.seen.clear();
+            _stack.busy = false;
+        }
+        ParseStack& operator*(){ return _stack; }
+
+    private:
+        ParseStack _own;
+        ParseStack& _stack;
+    };
+}
+
+static char32_t closerOf(EdnType kind)
 {
-    if(tokenmatch(r, "nil")){
-        return NilType();
+    switch(kind){
+        case T_List:   return U')';
+        case T_Vector: return U']';
+        case T_Map:
+        case T_Set:    return U'}';
+        default:       return 0;
     }
-    return std::nullopt;
 }
 
-static std::optional<ValueType> readBool(Utf8Reader& r)
+static void pushFrame(ParseStack& s, const ReadOptions& opts, Frame frame)
 {
-    if(tokenmatch(r, "true")) return BoolType{ true };
-    if(tokenmatch(r, "false")) return BoolType{ false };
-    return std::nullopt;
+    if(s.frames.size() >= opts.maxDepth){
+        std::ostringstream msg;
+        msg << "EDN nested deeper than maxDepth: " << opts.maxDepth;
+        throw std::runtime_error(msg.str());
+    }
+    frame.base = s.values.size();
+    frame.seen = s.seen.size();
+    s.frames.push_back(std::move(frame));
 }
 
-static std::optional<ValueType> readInteger(Utf8Reader&)
+// #tag or #ns/tag, the # already consumed
+static void readTagged(Utf8Reader& r, Frame& frame)
 {
-    boom("readInteger");
-    return {};
+    auto first = r.peek();
+    bool alpha = (first >= U'a' && first <= U'z') || (first >= U'A' && first <= U'Z') || (first > 0x7f && first != char32_t(-1));
+    if(!alpha)
+        throw std::runtime_error("Tag must start with an alphabetic character");
+    auto name = r.getWhile([](char32_t ch){ return !isterminator(ch) && ch != U'"' && ch != U';'; });
+    auto slash = name.find(U'/');
+    if(slash != std::u32string::npos && name.size() > 1){
+        frame.ns = name.substr(0, slash);
+        frame.tag = name.substr(slash + 1);
+    }
+    else
+        frame.tag = std::move(name);
 }
 
-static std::optional<ValueType> readFloat(Utf8Reader& r)
+// schema checks, made only when ReadOptions::schema is set
+
+// the schema the next form must match
+static Schema::Ref expected(const ParseStack& s, const Schema& schema)
 {
-    // auto buf = r.getUntil(r, isterminator);
-    boom("readFloat");
-    return {};
+    if(s.frames.empty()) return schema.root();
+    auto& top = s.frames.back();
+    auto& node = schema.node(top.schema);
+    switch(top.kind){
+        case T_Discard: return schema.any();
+        case T_Tagged:  return top.schema;
+        case T_Map:{
+            bool key = (s.values.size() - top.base) % 2 == 0;
+            if(node.record) return key ? schema.any() : top.pending;
+            return key ? node.key : node.value;
+        }
+        default:        return node.value;
+    }
 }
 
-std::optional<ValueType> readValue(Utf8Reader& r)
+static std::string keyText(const ValueType& v)
 {
-    std::optional<ValueType> result;
-    while(!result){
-        r.getWhile(iswhitespace);
-        auto ch = r.peek();
-        if(ch == char32_t(-1))
-            return {};
+    std::ostringstream out;
+    switch(edntype(v)){
+        case T_Nil:     out << "nil"; break;
+        case T_Bool:    out << (std::any_cast<BoolType>(v) ? "true" : "false"); break;
+        case T_String:  out << '"' << encodeUtf8(std::any_cast<const StringType&>(v)) << '"'; break;
+        case T_Integer: out << std::any_cast<IntegerType>(v); break;
+        case T_Float:   out << std::any_cast<FloatType>(v); break;
+        case T_Keyword:{
+            auto& k = std::any_cast<const KeywordType&>(v);
+            out << ':' << (k.ns.empty() ? "" : encodeUtf8(k.ns) + "/") << encodeUtf8(k.keyword);
+            break;
+        }
+        case T_Symbol:{
+            auto& k = std::any_cast<const SymbolType&>(v);
+            out << (k.ns.empty() ? "" : encodeUtf8(k.ns) + "/") << encodeUtf8(k.symbol);
+            break;
+        }
+        default:        out << '<' << typenameof(v) << '>';
+    }
+    return out.str();
+}
+
+// where the reader is, as [index :key ...] from the top level form down
+// through the first depth frames
+static std::string pathOf(const ParseStack& s, std::size_t depth)
+{
+    std::ostringstream out;
+    out << '[';
+    for(std::size_t ix = 0; ix < depth; ++ix){
+        auto& f = s.frames[ix];
+        auto pos = (ix + 1 < s.frames.size() ? s.frames[ix + 1].base : s.values.size()) - f.base;
+        if(ix) out << ' ';
+        switch(f.kind){
+            case T_Tagged:  out << '#' << (f.ns.empty() ? "" : encodeUtf8(f.ns) + "/") << encodeUtf8(f.tag); break;
+            case T_Discard: out << "#_"; break;
+            case T_Map:{
+                if(pos % 2) out << keyText(s.values[f.base + pos - 1]);
+                else out << "<key>";
+                break;
+            }
+            default:        out << pos;
+        }
+    }
+    out << ']';
+    return out.str();
+}
+
+static void violation(const ParseStack& s, std::size_t depth, std::size_t offset, const std::string& what)
+{
+    auto path = pathOf(s, depth);
+    std::ostringstream msg;
+    msg << "Schema violation at " << path << " @ byte " << offset << ": " << what;
+    throw SchemaError(msg.str(), std::move(path), offset);
+}
+
+static void expect(const ParseStack& s, const Schema& schema, Schema::Ref want, EdnType got, std::size_t offset)
+{
+    if(schema.accepts(want, got)) return;
+    auto& node = schema.node(want);
+    violation(s, s.frames.size(), offset,
+              "expected " + typenameof(node.kind) + (node.nullable ? " or nil" : "") + ", got " + typenameof(got));
+}
+
+// a key has arrived in a record: look up the schema its value must match
+static void enterKey(ParseStack& s, const Schema& schema, const ValueType& key, EdnType kind, std::size_t offset)
+{
+    auto& top = s.frames.back();
+    auto& node = schema.node(top.schema);
+    if(!node.record || (s.values.size() - top.base) % 2) return;
+    if(auto f = schema.field(top.schema, key, kind)){
+        // flagged per field, so a repeated key cannot stand in for a missing one
+        auto& seen = s.seen[top.seen + (f - schema.fieldsOf(top.schema))];
+        if(seen)
+            violation(s, s.frames.size(), offset, "duplicate key " + keyText(key));
+        seen = 1;
+        top.pending = f->value;
+        top.required += f->required;
+    }
+    else if(node.closed)
+        violation(s, s.frames.size(), offset, "unexpected key " + keyText(key));
+    else
+        top.pending = schema.any();
+}
 
-        // comments    
-        if(ch == U';'){
-            eatcomment(r);
-            continue;
+// a record is closing: every required key must be there
+static void checkRequired(const ParseStack& s, const Schema& schema, std::size_t offset)
+{
+    auto& top = s.frames.back();
+    auto& node = schema.node(top.schema);
+    if(!node.record || top.required >= node.required) return;
+    auto fields = schema.fieldsOf(top.schema);
+    for(std::uint32_t ix = 0; ix < node.count; ++ix){
+        if(!fields[ix].required) continue;
+        bool found = false;
+        for(auto k = top.base; k < s.values.size() && !found; k += 2)
+            found = equals(s.values[k], fields[ix].key);
+        if(!found)
+            violation(s, s.frames.size() - 1, offset, "missing required key " + keyText(fields[ix].key));
+    }
+}
+
+// opens a collection, tag or discard that starts at byte offset begin
+static void openFrame(ParseStack& s, const ReadOptions& opts, Frame frame, std::size_t begin)
+{
+    if(opts.schema && frame.kind != T_Discard){
+        auto& schema = *opts.schema;
+        auto want = expected(s, schema);
+        expect(s, schema, want, frame.kind, begin);
+        frame.schema = want;
+        if(frame.kind == T_Tagged){
+            auto& node = schema.node(want);
+            if(node.kind == T_Tagged && (node.ns != frame.ns || node.tag != frame.tag)){
+                auto name = [](const std::u32string& ns, const std::u32string& tag){
+                    return "#" + (ns.empty() ? "" : encodeUtf8(ns) + "/") + encodeUtf8(tag);
+                };
+                violation(s, s.frames.size(), begin, "expected " + name(node.ns, node.tag) + ", got " + name(frame.ns, frame.tag));
+            }
+            frame.schema = node.value;
         }
-        const auto& loc = r.loc();
-        
+    }
+    frame.begin = begin;
+    pushFrame(s, opts, std::move(frame));
+    auto& top = s.frames.back();
+    if(opts.schema && top.kind == T_Map){
+        auto& node = opts.schema->node(top.schema);
+        if(node.record) s.seen.resize(top.seen + node.count, 0);
+    }
+}
+
+// collections are built once all elements are known, so storage is sized exactly
+static ValueType readList(ParseStack& s, std::size_t base)
+{
+    return ListType(std::make_move_iterator(s.values.begin() + base), std::make_move_iterator(s.values.end()));
+}
+
+static ValueType readVector(ParseStack& s, std::size_t base)
+{
+    return VectorType(std::make_move_iterator(s.values.begin() + base), std::make_move_iterator(s.values.end()));
+}
+
+static ValueType readMap(ParseStack& s, std::size_t base)
+{
+    auto n = s.values.size() - base;
+    if(n % 2)
+        throw std::runtime_error("Map literal must contain an even number of forms");
+    MapType result;
+    result.reserve(n / 2);
+    for(auto ix = base; ix < s.values.size(); ix += 2){
+        if(!result.insert(std::move(s.values[ix]), std::move(s.values[ix+1])))
+            throw std::runtime_error("Duplicate key in map literal");
+    }
+    return result;
+}
+
+static ValueType readSet(ParseStack& s, std::size_t base)
+{
+    SetType result;
+    result.reserve(s.values.size() - base);
+    for(auto ix = base; ix < s.values.size(); ++ix){
+        if(!result.insert(std::move(s.values[ix])))
+            throw std::runtime_error("Duplicate item in set literal");
+    }
+    return result;
+}
+
+static ValueType closeCollection(ParseStack& s, const ReadOptions& opts)
+{
+    auto kind = s.frames.back().kind;
+    auto base = s.frames.back().base;
+    s.seen.resize(s.frames.back().seen);
+    s.frames.pop_back();
+    if(opts.validateOnly){
+        if(kind == T_Map && (s.values.size() - base) % 2)
+            throw std::runtime_error("Map literal must contain an even number of forms");
+        s.values.erase(s.values.begin() + base, s.values.end());
+        return NilType{};
+    }
+    ValueType result;
+    switch(kind){
+        case T_List:   result = readList(s, base);   break;
+        case T_Vector: result = readVector(s, base); break;
+        case T_Map:    result = readMap(s, base);    break;
+        case T_Set:    result = readSet(s, base);    break;
+        default:       throw std::logic_error("closeCollection on a non-collection frame");
+    }
+    s.values.erase(s.values.begin() + base, s.values.end());
+    return finish(opts, std::move(result));
+}
+
+std::optional<ValueType> readValue(Utf8Reader& r, const ReadOptions& opts)
+{
+    StackLease lease;
+    auto& s = *lease;
+    const Schema* schema = opts.schema;
+    while(true){
+        skipws(r);
+        auto ch = r.peek();
+        auto begin = r.offset();
+        ValueType value;
+        EdnType kind = T_Invalid;
         switch(ch){
-            case U'"':     result = readString(r);   break;
-            case U'\'':    result = readChar(r);     break;
-            case U':':     result = readKeyword(r);  break;
-            case U'(':     result = readList(r);     break;
-            case U'[':     result = readVector(r);   break;
-            case U'{':     result = readMap(r);      break;
-            case U'#': {
-                if(result = readSet(r)) break;
-                if(result = readTagged(r)) break;
-                if(result = readDiscard(r)) continue;
+            case char32_t(-1):{
+                if(s.frames.empty())
+                    return std::nullopt;
+                std::ostringstream msg;
+                msg << "EOF while reading " << typenameof(s.frames.back().kind);
+                throw std::runtime_error(msg.str());
             }
-            default:{
-                if(result = readNil(r)) break;
-                if(result = readBool(r)) break;
-                if(result = readInteger(r)) break;
-                if(result = readFloat(r)) break;
-                if(result = readSymbol(r)) break;
+            case U'(': r.get(); openFrame(s, opts, Frame(T_List), begin);   continue;
+            case U'[': r.get(); openFrame(s, opts, Frame(T_Vector), begin); continue;
+            case U'{': r.get(); openFrame(s, opts, Frame(T_Map), begin);    continue;
+            case U')':
+            case U']':
+            case U'}':{
+                if(s.frames.empty() || closerOf(s.frames.back().kind) != ch){
+                    std::ostringstream msg;
+                    msg << "Unmatched delimiter: " << char(ch);
+                    throw std::runtime_error(msg.str());
+                }
+                if(schema) checkRequired(s, *schema, begin);
+                r.get();
+                begin = s.frames.back().begin;
+                kind = s.frames.back().kind;
+                value = closeCollection(s, opts);
+                break;
+            }
+            case U'#':{
+                r.get();
+                auto next = r.peek();
+                if(next == U'{'){
+                    r.get();
+                    openFrame(s, opts, Frame(T_Set), begin);
+                }
+                else if(next == U'_'){
+                    r.get();
+                    openFrame(s, opts, Frame(T_Discard), begin);
+                }
+                else{
+                    Frame frame(T_Tagged);
+                    readTagged(r, frame);
+                    openFrame(s, opts, std::move(frame), begin);
+                }
+                continue;
+            }
+            default:
+                value = readScalar(r, kind);
+                if(schema) expect(s, *schema, expected(s, *schema), kind, begin);
+        }
+
+        // hand the finished value to whatever is waiting for it
+        bool consumed = false;
+        while(!consumed && !s.frames.empty()){
+            auto& top = s.frames.back();
+            if(top.kind == T_Tagged){
+                if(!opts.validateOnly)
+                    value = TaggedType{std::move(top.ns), std::move(top.tag), std::move(value)};
+                begin = top.begin;
+                kind = T_Tagged;
+                s.frames.pop_back();
+            }
+            else if(top.kind == T_Discard){
+                s.frames.pop_back();
+                consumed = true;
+            }
+            else{
+                bool key = top.kind == T_Map && (s.values.size() - top.base) % 2 == 0;
+                if(schema && key) enterKey(s, *schema, value, kind, begin);
+                // validating, only map keys are kept: records look them up
+                // at the close, error paths name them
+                if(opts.validateOnly && !key) value = NilType{};
+                s.values.push_back(std::move(value));
+                consumed = true;
             }
         }
-        if(!result){
-            std::ostringstream msg;
-            msg << "Unable to recognize EDN @ line: " << loc.first << " col: " << loc.second;
-            throw std::runtime_error(msg.str());
+        if(!consumed){
+            if(opts.validateOnly) return NilType{};
+            return value;
         }
-        break;
     }
-    return result;
 }
 
-} // namespace 
+} // namespace
@@ -0,0 +1,228 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/ednrelease.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace edncxx;
+
+// per-thread node free lists, size classes in 16 byte steps.  kept trivially
+// destructible so nodes freed late in thread teardown can still look at it.
+namespace{
+
+    const std::size_t Granule = 16;
+    const std::size_t Classes = 64;
+    const std::size_t CacheLimit = 4 << 20;
+
+    struct NodeCache{
+        void* heads[Classes];
+        std::size_t bytes;
+        bool recycling;
+    };
+    thread_local NodeCache cache;
+
+    void trim()
+    {
+        for(auto& head : cache.heads){
+            while(head){
+                auto next = *static_cast<void**>(head);
+                ::operator delete(head);
+                head = next;
+            }
+        }
+        cache.bytes = 0;
+    }
+
+    struct CacheTrimmer{ ~CacheTrimmer(){ trim(); } };
+    thread_local CacheTrimmer trimmer;
+
+    std::size_t classOf(std::size_t bytes){ return (bytes + Granule - 1) / Granule - 1; }
+
+    struct RecycleScope{
+        RecycleScope(){ cache.recycling = true; }
+        ~RecycleScope(){ cache.recycling = false; }
+    };
+}
+
+namespace edncxx{
+namespace detail{
+
+void* allocNode(std::size_t bytes)
+{
+    auto cls = classOf(bytes);
+    if(cls >= Classes)
+        return ::operator new(bytes);
+    if(auto head = cache.heads[cls]){
+        cache.heads[cls] = *static_cast<void**>(head);
+        cache.bytes -= (cls + 1) * Granule;
+        return head;
+    }
+    // whole class size, so the block can serve any request in its class later
+    return ::operator new((cls + 1) * Granule);
+}
+
+void freeNode(void* mem, std::size_t bytes)
+{
+    auto cls = classOf(bytes);
+    auto size = (cls + 1) * Granule;
+    if(!cache.recycling || cls >= Classes || cache.bytes + size > CacheLimit){
+        ::operator delete(mem);
+        return;
+    }
+    (void)&trimmer;
+    *static_cast<void**>(mem) = cache.heads[cls];
+    cache.heads[cls] = mem;
+    cache.bytes += size;
+}
+
+} // detail
+
+// the walk: anything we own outright is gutted onto an explicit stack before
+// it dies, so no destructor ever recurses more than one level
+static void teardown(ValueType&& root)
+{
+    std::vector<ValueType> stack;
+    stack.push_back(std::move(root));
+    auto push = [&](ValueType&& v){ if(v.has_value()) stack.push_back(std::move(v)); };
+
+    while(!stack.empty()){
+        auto v = std::move(stack.back());
+        stack.pop_back();
+        switch(edntype(v)){
+            case T_List:    std::any_cast<ListType&>(v).drain(push); break;
+            case T_Vector:  std::any_cast<VectorType&>(v).drain(push); break;
+            case T_Set:     std::any_cast<SetType&>(v).drain(push); break;
+            case T_Map:
+                std::any_cast<MapType&>(v).drain([&](std::pair<ValueType, ValueType>&& entry){
+                    push(std::move(entry.first));
+                    push(std::move(entry.second));
+                });
+                break;
+            case T_Tagged:  push(std::move(std::any_cast<TaggedType&>(v).rep)); break;
+            case T_Discard: push(std::move(std::any_cast<DiscardType&>(v).discarded)); break;
+            default: break;
+        }
+    }
+}
+
+namespace{
+
+    class Reclaimer{
+    public:
+        Reclaimer() : _thread([this]{ run(); }) {}
+        ~Reclaimer(){
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _wake.notify_all();
+            _thread.join();
+        }
+
+        void add(ValueType&& v){
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _queue.push_back(std::move(v));
+            }
+            _wake.notify_all();
+        }
+
+        void flush(){
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idle.wait(lock, [this]{ return _queue.empty() && !_busy; });
+        }
+
+    private:
+        void run(){
+            std::unique_lock<std::mutex> lock(_mutex);
+            while(true){
+                _wake.wait(lock, [this]{ return _stop || !_queue.empty(); });
+                if(_queue.empty() && _stop) return;
+                auto batch = std::move(_queue);
+                _queue.clear();
+                _busy = true;
+                lock.unlock();
+                for(auto& v : batch)
+                    teardown(std::move(v));
+                batch.clear();
+                lock.lock();
+                _busy = false;
+                _idle.notify_all();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _idle;
+        std::deque<ValueType> _queue;
+        bool _busy = false;
+        bool _stop = false;
+        std::thread _thread;
+    };
+
+    Reclaimer& reclaimer()
+    {
+        static Reclaimer instance;
+        return instance;
+    }
+}
+
+void release(ValueType&& value, Reclaim how)
+{
+    switch(how){
+        case Reclaim::Now:
+            teardown(std::move(value));
+            break;
+        case Reclaim::Recycle:{
+            RecycleScope scope;
+            teardown(std::move(value));
+            break;
+        }
+        case Reclaim::Background:
+            reclaimer().add(std::move(value));
+            break;
+    }
+}
+
+void flushReclaimer()
+{
+    reclaimer().flush();
+}
+
+std::size_t cachedNodeBytes()
+{
+    return cache.bytes;
+}
+
+void trimNodeCache()
+{
+    trim();
+}
+
+} // ns
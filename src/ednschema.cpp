@@ -0,0 +1,199 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <edncxx/ednschema.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace edncxx;
+namespace edncxx{
+
+Schema::Schema()
+{
+    _nodes.emplace_back();
+}
+
+Schema::Ref Schema::add(Node node)
+{
+    _nodes.push_back(std::move(node));
+    return static_cast<Ref>(_nodes.size() - 1);
+}
+
+void Schema::check(Ref ref) const
+{
+    if(ref >= _nodes.size())
+        throw std::runtime_error("Schema node does not exist");
+}
+
+Schema::Ref Schema::scalar(EdnType kind)
+{
+    if(kind < T_Nil || kind > T_Float){
+        std::ostringstream msg;
+        msg << "Schema scalar of non-scalar type: " << typenameof(kind);
+        throw std::runtime_error(msg.str());
+    }
+    Node node;
+    node.kind = kind;
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::list(Ref element)
+{
+    check(element);
+    Node node;
+    node.kind = T_List;
+    node.value = element;
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::vector(Ref element)
+{
+    check(element);
+    Node node;
+    node.kind = T_Vector;
+    node.value = element;
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::set(Ref element)
+{
+    check(element);
+    Node node;
+    node.kind = T_Set;
+    node.value = element;
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::map(Ref key, Ref value)
+{
+    check(key);
+    check(value);
+    Node node;
+    node.kind = T_Map;
+    node.key = key;
+    node.value = value;
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::record(std::vector<Field> fields, bool closed)
+{
+    for(auto ix = 0u; ix < fields.size(); ++ix){
+        check(fields[ix].value);
+        for(auto jx = 0u; jx < ix; ++jx)
+            if(equals(fields[jx].key, fields[ix].key))
+                throw std::runtime_error("Duplicate key in schema record");
+    }
+    Node node;
+    node.kind = T_Map;
+    node.record = true;
+    node.closed = closed;
+    node.first = static_cast<std::uint32_t>(_fields.size());
+    node.count = static_cast<std::uint32_t>(fields.size());
+    for(auto& f : fields){
+        node.required += f.required;
+        _byHash.emplace_back(hashof(f.key), static_cast<std::uint32_t>(_fields.size()));
+        _kinds.push_back(edntype(f.key));
+        _fields.push_back(std::move(f));
+    }
+    std::sort(_byHash.begin() + node.first, _byHash.end());
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::tagged(std::u32string ns, std::u32string tag, Ref rep)
+{
+    check(rep);
+    Node node;
+    node.kind = T_Tagged;
+    node.ns = std::move(ns);
+    node.tag = std::move(tag);
+    node.value = rep;
+    return add(std::move(node));
+}
+
+Schema::Ref Schema::nullable(Ref ref)
+{
+    check(ref);
+    if(_nodes[ref].nullable || _nodes[ref].kind == T_Invalid) return ref;
+    Node node = _nodes[ref];
+    node.nullable = true;
+    return add(std::move(node));
+}
+
+void Schema::root(Ref ref)
+{
+    check(ref);
+    _root = ref;
+}
+
+bool Schema::accepts(Ref ref, EdnType kind) const
+{
+    auto& n = _nodes[ref];
+    return n.kind == T_Invalid || n.kind == kind || (n.nullable && kind == T_Nil);
+}
+
+// strings and keywords, the usual keys, compare without dispatching on type
+static bool sameKey(const ValueType& a, const ValueType& b, EdnType kind)
+{
+    switch(kind){
+        case T_String:  return *std::any_cast<StringType>(&a) == *std::any_cast<StringType>(&b);
+        case T_Keyword:{
+            auto x = std::any_cast<KeywordType>(&a);
+            auto y = std::any_cast<KeywordType>(&b);
+            return x->keyword == y->keyword && x->ns == y->ns;
+        }
+        default:        return equals(a, b);
+    }
+}
+
+const Schema::Field* Schema::field(Ref record, const ValueType& key) const
+{
+    return field(record, key, edntype(key));
+}
+
+const Schema::Field* Schema::field(Ref record, const ValueType& key, EdnType kind) const
+{
+    auto& n = _nodes[record];
+    auto end = n.first + n.count;
+    // a short scan is cheaper than hashing the key
+    if(n.count <= ScanLimit){
+        for(auto ix = n.first; ix < end; ++ix)
+            if(_kinds[ix] == kind && sameKey(_fields[ix].key, key, kind))
+                return &_fields[ix];
+        return nullptr;
+    }
+    // binary search of the record's hash run
+    auto h = hashof(key);
+    auto it = std::lower_bound(_byHash.begin() + n.first, _byHash.begin() + end, std::make_pair(h, std::uint32_t(0)));
+    for(; it != _byHash.begin() + end && it->first == h; ++it)
+        if(_kinds[it->second] == kind && sameKey(_fields[it->second].key, key, kind))
+            return &_fields[it->second];
+    return nullptr;
+}
+
+SchemaError::SchemaError(const std::string& what, std::string path, std::size_t offset)
+    : std::runtime_error(what), _path(std::move(path)), _offset(offset)
+{
+}
+
+} // ns
@@ -1,4 +1,3 @@
-
 // The MIT License (MIT)
 //
 // Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
@@ -21,51 +20,286 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+
 #include <edncxx/utf8cvt.h>
 
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 
 using namespace edncxx;
 namespace edncxx{
 
-// needed to thwart protected dtor
-class utf8codecvt : public std::codecvt<char32_t, char, std::mbstate_t>{
-};
+// ascii runs are the common case, test and copy them a word at a time
+static const std::uint64_t HighBits = 0x8080808080808080ull;
 
+static std::size_t asciiRun(const char* from, std::size_t n)
+{
+    std::size_t ix = 0;
+    for(; ix + 8 <= n; ix += 8){
+        std::uint64_t word;
+        std::memcpy(&word, from + ix, 8);
+        if(word & HighBits) break;
+    }
+    while(ix < n && !(static_cast<unsigned char>(from[ix]) & 0x80)) ++ix;
+    return ix;
+}
 
-std::string encodeUtf8(const std::u32string& from)
+static bool isScalar(char32_t cp)
 {
-    utf8codecvt cvt;
-    std::mbstate_t state = {};
+    return cp < 0xd800 || (cp > 0xdfff && cp <= 0x10ffff);
+}
 
-    std::string to(4*from.size(), 0);
-    char* to_next;
-    const char32_t* from_next;
-    auto rc = cvt.out(state, from.data(), from.data() + from.size(), from_next,
-                      to.data(), to.data()+to.size(), to_next);
-    if(rc != utf8codecvt::ok){
-        std::ostringstream msg;
-        msg << "encodeUtf8 returned unexpected state: " << int(rc);
-        throw std::runtime_error(msg.str());
+static bool isTrail(unsigned char b)
+{
+    return (b & 0xc0) == 0x80;
+}
+
+// code units needed for cp
+static std::size_t units8(char32_t cp)  { return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4; }
+static std::size_t units16(char32_t cp) { return cp < 0x10000 ? 1 : 2; }
+
+static std::size_t put(char* to, char32_t cp)
+{
+    if(cp < 0x80){
+        to[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if(cp < 0x800){
+        to[0] = static_cast<char>(0xc0 | (cp >> 6));
+        to[1] = static_cast<char>(0x80 | (cp & 0x3f));
+        return 2;
     }
-    return to.substr(0, to_next - to.data());
+    if(cp < 0x10000){
+        to[0] = static_cast<char>(0xe0 | (cp >> 12));
+        to[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        to[2] = static_cast<char>(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    to[0] = static_cast<char>(0xf0 | (cp >> 18));
+    to[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+    to[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    to[3] = static_cast<char>(0x80 | (cp & 0x3f));
+    return 4;
 }
 
-std::u32string decodeUtf8(const std::string& from)
+static std::size_t put(char16_t* to, char32_t cp)
+{
+    if(cp < 0x10000){
+        to[0] = static_cast<char16_t>(cp);
+        return 1;
+    }
+    cp -= 0x10000;
+    to[0] = static_cast<char16_t>(0xd800 | (cp >> 10));
+    to[1] = static_cast<char16_t>(0xdc00 | (cp & 0x3ff));
+    return 2;
+}
+
+static std::size_t put(char32_t* to, char32_t cp)
+{
+    to[0] = cp;
+    return 1;
+}
+
+static std::size_t unitsFor(char*, char32_t cp)     { return units8(cp); }
+static std::size_t unitsFor(char16_t*, char32_t cp) { return units16(cp); }
+static std::size_t unitsFor(char32_t*, char32_t)    { return 1; }
+
+template<bool Validate, typename Out>
+static CvtResult encode(std::u32string_view from, Out* to, std::size_t capacity)
+{
+    CvtResult result;
+    for(auto cp : from){
+        if(Validate && !isScalar(cp)){
+            result.ok = false;
+            return result;
+        }
+        if(result.written + unitsFor(to, cp) > capacity){
+            result.ok = false;
+            return result;
+        }
+        result.written += put(to + result.written, cp);
+        ++result.read;
+    }
+    return result;
+}
+
+// length of the well formed sequence starting at from[0], 0 if there is none
+static std::size_t sequenceAt(const unsigned char* from, std::size_t n, char32_t& cp)
+{
+    auto lead = from[0];
+    std::size_t len;
+    unsigned char lo = 0x80, hi = 0xbf;
+    if(lead < 0x80){ cp = lead; return 1; }
+    else if(lead < 0xc2) return 0;
+    else if(lead < 0xe0){ len = 2; cp = lead & 0x1f; }
+    else if(lead < 0xf0){
+        len = 3; cp = lead & 0x0f;
+        if(lead == 0xe0) lo = 0xa0;
+        if(lead == 0xed) hi = 0x9f;
+    }
+    else if(lead < 0xf5){
+        len = 4; cp = lead & 0x07;
+        if(lead == 0xf0) lo = 0x90;
+        if(lead == 0xf4) hi = 0x8f;
+    }
+    else return 0;
+
+    if(n < len) return 0;
+    if(from[1] < lo || from[1] > hi) return 0;
+    cp = (cp << 6) | (from[1] & 0x3f);
+    for(std::size_t ix = 2; ix < len; ++ix){
+        if(!isTrail(from[ix])) return 0;
+        cp = (cp << 6) | (from[ix] & 0x3f);
+    }
+    return len;
+}
+
+// trusted input, the lead byte alone gives the length
+static std::size_t sequenceAtUnchecked(const unsigned char* from, char32_t& cp)
+{
+    auto lead = from[0];
+    if(lead < 0x80){ cp = lead; return 1; }
+    if(lead < 0xe0){ cp = ((lead & 0x1f) << 6) | (from[1] & 0x3f); return 2; }
+    if(lead < 0xf0){ cp = ((lead & 0x0f) << 12) | ((from[1] & 0x3f) << 6) | (from[2] & 0x3f); return 3; }
+    cp = ((lead & 0x07) << 18) | ((from[1] & 0x3f) << 12) | ((from[2] & 0x3f) << 6) | (from[3] & 0x3f);
+    return 4;
+}
+
+template<bool Validate, typename Out>
+static CvtResult decode(std::string_view from, Out* to, std::size_t capacity)
+{
+    CvtResult result;
+    auto bytes = reinterpret_cast<const unsigned char*>(from.data());
+    auto n = from.size();
+    while(result.read < n){
+        auto run = asciiRun(from.data() + result.read, std::min(n - result.read, capacity - result.written));
+        for(std::size_t ix = 0; ix < run; ++ix)
+            to[result.written + ix] = static_cast<Out>(bytes[result.read + ix]);
+        result.read += run;
+        result.written += run;
+        if(result.read == n) break;
+
+        char32_t cp;
+        std::size_t len = Validate ? sequenceAt(bytes + result.read, n - result.read, cp)
+                                   : sequenceAtUnchecked(bytes + result.read, cp);
+        if(!len || result.written + unitsFor(to, cp) > capacity){
+            result.ok = false;
+            return result;
+        }
+        result.written += put(to + result.written, cp);
+        result.read += len;
+    }
+    return result;
+}
+
+std::size_t utf8LengthOf(std::u32string_view from)
+{
+    std::size_t n = 0;
+    for(auto cp : from) n += units8(cp);
+    return n;
+}
+
+std::size_t utf16LengthOf(std::u32string_view from)
 {
-    utf8codecvt cvt;
-    std::mbstate_t state = {};
-    std::u32string to(from.size(), 0);
-    char32_t* to_next;
-    const char* from_next;
-    auto rc = cvt.in(state, from.data(), from.data() + from.size(), from_next,
-                    to.data(), to.data()+to.size(), to_next);
-    if(rc != utf8codecvt::ok){
+    std::size_t n = 0;
+    for(auto cp : from) n += units16(cp);
+    return n;
+}
+
+std::size_t utf32LengthOf(std::string_view from)
+{
+    std::size_t n = 0;
+    for(auto ch : from) n += !isTrail(static_cast<unsigned char>(ch));
+    return n;
+}
+
+std::size_t utf16LengthOf(std::string_view from)
+{
+    std::size_t n = 0;
+    for(auto ch : from){
+        auto b = static_cast<unsigned char>(ch);
+        n += !isTrail(b) + (b >= 0xf0);
+    }
+    return n;
+}
+
+CvtResult encodeUtf8(std::u32string_view from, char* to, std::size_t capacity)
+{
+    return encode<true>(from, to, capacity);
+}
+
+CvtResult encodeUtf16(std::u32string_view from, char16_t* to, std::size_t capacity)
+{
+    return encode<true>(from, to, capacity);
+}
+
+CvtResult decodeUtf8(std::string_view from, char32_t* to, std::size_t capacity)
+{
+    return decode<true>(from, to, capacity);
+}
+
+CvtResult utf8ToUtf16(std::string_view from, char16_t* to, std::size_t capacity)
+{
+    return decode<true>(from, to, capacity);
+}
+
+static const auto Unbounded = std::numeric_limits<std::size_t>::max();
+
+std::size_t encodeUtf8Unchecked(std::u32string_view from, char* to)
+{
+    return encode<false>(from, to, Unbounded).written;
+}
+
+std::size_t decodeUtf8Unchecked(std::string_view from, char32_t* to)
+{
+    return decode<false>(from, to, Unbounded).written;
+}
+
+std::size_t utf8ToUtf16Unchecked(std::string_view from, char16_t* to)
+{
+    return decode<false>(from, to, Unbounded).written;
+}
+
+// size the result exactly up front, one allocation and no trailing copy
+template<typename To, typename From, typename Fn>
+static To convert(const char* what, const From& from, std::size_t length, Fn fn)
+{
+    To to(length, 0);
+    auto rc = fn(from, to.data(), to.size());
+    if(!rc.ok){
         std::ostringstream msg;
-        msg << "decodeUtf8 returned unexpected state: " << int(rc);
+        msg << what << " invalid input at offset: " << rc.read;
         throw std::runtime_error(msg.str());
     }
-    return to.substr(0, to_next - to.data());
+    to.resize(rc.written);
+    return to;
+}
+
+std::string encodeUtf8(const std::u32string& from)
+{
+    return convert<std::string>("encodeUtf8", from, utf8LengthOf(from),
+        [](std::u32string_view f, char* t, std::size_t n){ return encodeUtf8(f, t, n); });
+}
+
+std::u16string encodeUtf16(const std::u32string& from)
+{
+    return convert<std::u16string>("encodeUtf16", from, utf16LengthOf(from),
+        [](std::u32string_view f, char16_t* t, std::size_t n){ return encodeUtf16(f, t, n); });
+}
+
+std::u32string decodeUtf8(const std::string& from)
+{
+    return convert<std::u32string>("decodeUtf8", from, utf32LengthOf(from),
+        [](std::string_view f, char32_t* t, std::size_t n){ return decodeUtf8(f, t, n); });
+}
+
+std::u16string utf8ToUtf16(const std::string& from)
+{
+    return convert<std::u16string>("utf8ToUtf16", from, utf16LengthOf(from),
+        [](std::string_view f, char16_t* t, std::size_t n){ return utf8ToUtf16(f, t, n); });
 }
-} // ns
\ No newline at end of file
+} // ns
@@ -71,11 +71,18 @@ static char32_t decode(char32_t& state, char32_t& codep, char32_t abyte)
     return state;
 }
 
+// bytes ch took in the source
+static std::size_t encodedLength(char32_t ch)
+{
+    return ch < 0x80 ? 1 : ch < 0x800 ? 2 : ch < 0x10000 ? 3 : 4;
+}
+
 char32_t Utf8Reader::get()
 {
     if(!_pushback.empty()){
         auto ch = _pushback.back();
         _pushback.pop_back();
+        _offset += encodedLength(ch);
         return ch;
     }
 
@@ -87,6 +94,7 @@ char32_t Utf8Reader::get()
         abyte = _source.get();
         if(_source.eof() || _source.fail())
             return char32_t(-1);
+        ++_offset;
 
     } while (decode(state, codep, abyte));
     return codep;
@@ -101,8 +109,10 @@ char32_t Utf8Reader::peek()
 
 void Utf8Reader::unget(char32_t ch)
 {
-    if(ch != char32_t(-1))
+    if(ch != char32_t(-1)){
         _pushback.push_back(ch);
+        _offset -= encodedLength(ch);
+    }
 }
 
 void Utf8Reader::unget(const std::u32string_view& str)
@@ -116,7 +126,7 @@ std::u32string Utf8Reader::getWhile(std::function<bool(char32_t)> pred)
     std::u32string result;
     while(true){
         auto ch = get();
-        if(pred(ch))
+        if(ch != char32_t(-1) && pred(ch))
             result.push_back(ch);
         else{
             unget(ch);
@@ -131,7 +141,7 @@ std::u32string Utf8Reader::getUntil(std::function<bool(char32_t)> pred)
     std::u32string result;
     while(true){
         auto ch = get();
-        if(pred(ch)){
+        if(ch == char32_t(-1) || pred(ch)){
             unget(ch);
             return result;
         }
@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <edncxx/decompress.h>
+#include <edncxx/utf8reader.h>
+#include <edncxx/ednreader.h>
+#include <edncxx/ednany.h>
+using namespace edncxx;
+
+// two concatenated gzip members:  ["alpha" "beta" {"k" true} nil]  and  (false)
+static const char gzipped[] =
+    "\x1f\x8b\x08\x00\x95\xec\xd5\x6a\x02\xff\x8b\x56\x4a\xcc\x29\xc8\x48\x54\x52\x50\x4a\x4a\x2d\x01"
+    "\x52\xd5\x4a\xd9\x4a\x0a\x25\x45\xa5\xa9\xb5\x0a\x79\x99\x39\xb1\x00\x70\x00\xf3\x27\x1f\x00\x00"
+    "\x00\x1f\x8b\x08\x00\x95\xec\xd5\x6a\x02\xff\x53\xd0\x48\x4b\xcc\x29\x4e\xd5\x04\x00\x42\xe1\x86"
+    "\x67\x08\x00\x00\x00";
+
+// [ followed by 20000 "edn" and ], no checksum, 120002 bytes decoded
+static const char zstded[] =
+    "\x28\xb5\x2f\xfd\xa0\xc2\xd4\x01\x00\x85\x00\x00\x40\x5b\x22\x65\x64\x6e\x22\x20\x5d\x01\x00\xb7"
+    "\xd4\xc9\x8b\x11";
+
+static void readBoth(std::istream& input)
+{
+    Utf8Reader rdr(input);
+    auto vec = readValue(rdr);
+    ASSERT_TRUE(vec);
+    auto& v = std::any_cast<const VectorType&>(*vec);
+    ASSERT_EQ(v.size(), 4u);
+    EXPECT_EQ(std::any_cast<StringType>(v[1]), U"beta");
+    auto lst = readValue(rdr);
+    ASSERT_TRUE(lst);
+    EXPECT_EQ(edntype(*lst), EdnType::T_List);
+    EXPECT_FALSE(readValue(rdr));
+}
+
+TEST(decompress, PlainPassesThrough)
+{
+    std::istringstream raw("[\"alpha\" \"beta\" {\"k\" true} nil] (false)");
+    DecompressStream strm(raw, 5);
+    EXPECT_EQ(strm.format(), Compression::None);
+    readBoth(strm);
+}
+
+TEST(decompress, Gzip)
+{
+    if(!decompressionSupported(Compression::Gzip)) GTEST_SKIP();
+    for(std::size_t blockSize : {3u, 64u, 1u << 16}){
+        std::istringstream raw(std::string(gzipped, sizeof(gzipped) - 1));
+        DecompressStream strm(raw, blockSize);
+        EXPECT_EQ(strm.format(), Compression::Gzip);
+        readBoth(strm);
+    }
+}
+
+TEST(decompress, TruncatedGzipThrows)
+{
+    if(!decompressionSupported(Compression::Gzip)) GTEST_SKIP();
+    std::istringstream raw(std::string(gzipped, 30));
+    DecompressStream strm(raw);
+    Utf8Reader rdr(strm);
+    EXPECT_THROW(while(readValue(rdr)){}, std::runtime_error);
+}
+
+TEST(decompress, ZstdDetected)
+{
+    std::istringstream raw(std::string("\x28\xb5\x2f\xfd", 4));
+    if(decompressionSupported(Compression::Zstd)){
+        DecompressStream strm(raw);
+        EXPECT_EQ(strm.format(), Compression::Zstd);
+    }
+    else
+        EXPECT_THROW(DecompressStream strm(raw), std::runtime_error);
+}
+
+TEST(decompress, Zstd)
+{
+    if(!decompressionSupported(Compression::Zstd)) GTEST_SKIP();
+    // the whole frame is taken in at once, its output has to be drained over many blocks
+    for(std::size_t blockSize : {100u, 1u << 16}){
+        std::istringstream raw(std::string(zstded, sizeof(zstded) - 1));
+        DecompressStream strm(raw, blockSize);
+        EXPECT_EQ(strm.format(), Compression::Zstd);
+        Utf8Reader rdr(strm);
+        auto vec = readValue(rdr);
+        ASSERT_TRUE(vec);
+        auto& v = std::any_cast<const VectorType&>(*vec);
+        ASSERT_EQ(v.size(), 20000u);
+        EXPECT_EQ(std::any_cast<StringType>(v[19999]), U"edn");
+        EXPECT_FALSE(readValue(rdr));
+    }
+}
+
+TEST(decompress, TruncatedZstdThrows)
+{
+    if(!decompressionSupported(Compression::Zstd)) GTEST_SKIP();
+    std::istringstream raw(std::string(zstded, 20));
+    DecompressStream strm(raw);
+    Utf8Reader rdr(strm);
+    EXPECT_THROW(while(readValue(rdr)){}, std::runtime_error);
+}
+
+TEST(decompress, ZeroBlockSizeRejected)
+{
+    std::istringstream raw("nil");
+    EXPECT_THROW(DecompressStream strm(raw, 0), std::runtime_error);
+}
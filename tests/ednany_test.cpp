@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <set>
+#include <unordered_set>
+#include <edncxx/ednany.h>
+using namespace edncxx;
+
+TEST(ednany, HandlesFitInAny)
+{
+    EXPECT_EQ(sizeof(VectorType), sizeof(void*));
+    EXPECT_EQ(sizeof(MapType), sizeof(void*));
+    EXPECT_TRUE(std::is_nothrow_move_constructible_v<VectorType>);
+    EXPECT_NE(edntype(ListType{}), edntype(VectorType{}));
+}
+
+TEST(ednany, SequenceCopyOnWrite)
+{
+    VectorType a{IntegerType{1}, IntegerType{2}};
+    VectorType b = a;
+    EXPECT_TRUE(a.shares(b));
+    b.push_back(IntegerType{3});
+    EXPECT_FALSE(a.shares(b));
+    EXPECT_EQ(a.size(), 2u);
+    EXPECT_EQ(b.size(), 3u);
+    b.set(0, IntegerType{7});
+    EXPECT_EQ(std::any_cast<IntegerType>(a[0]), 1);
+    EXPECT_EQ(std::any_cast<IntegerType>(b[0]), 7);
+}
+
+TEST(ednany, MapPromotesPastFlatLimit)
+{
+    MapType m;
+    for(IntegerType ix = 0; ix < 8; ++ix)
+        EXPECT_TRUE(m.insert(ix, ix * 10));
+    EXPECT_FALSE(m.hashed());
+    EXPECT_FALSE(m.insert(IntegerType{3}, NilType{}));
+    EXPECT_TRUE(m.insert(IntegerType{8}, IntegerType{80}));
+    EXPECT_TRUE(m.hashed());
+    for(IntegerType ix = 0; ix < 9; ++ix)
+        EXPECT_EQ(std::any_cast<IntegerType>(m.at(ix)), ix * 10);
+
+    MapType copy = m;
+    copy.insert_or_assign(IntegerType{4}, StringType(U"four"));
+    EXPECT_EQ(std::any_cast<IntegerType>(m.at(IntegerType{4})), 40);
+    EXPECT_EQ(std::any_cast<StringType>(copy.at(IntegerType{4})), U"four");
+
+    EXPECT_TRUE(copy.erase(IntegerType{0}));
+    EXPECT_FALSE(copy.contains(IntegerType{0}));
+    EXPECT_TRUE(copy.contains(IntegerType{8}));
+    EXPECT_EQ(copy.size(), 8u);
+}
+
+TEST(ednany, StructuralEquality)
+{
+    MapType m1{{StringType(U"a"), IntegerType{1}}, {StringType(U"b"), VectorType{NilType{}}}};
+    MapType m2{{StringType(U"b"), VectorType{NilType{}}}, {StringType(U"a"), IntegerType{1}}};
+    EXPECT_TRUE(equals(m1, m2));
+    EXPECT_EQ(hashof(m1), hashof(m2));
+    EXPECT_EQ(hash2of(m1), hash2of(m2));
+    EXPECT_EQ(hash2of(VectorType{FloatType{0.0}}), hash2of(VectorType{FloatType{-0.0}}));
+    EXPECT_FALSE(equals(ListType{NilType{}}, VectorType{NilType{}}));
+    EXPECT_FALSE(equals(SetType{IntegerType{1}}, SetType{IntegerType{2}}));
+    EXPECT_TRUE(equals(SetType{IntegerType{1}, IntegerType{2}}, SetType{IntegerType{2}, IntegerType{1}}));
+}
+
+TEST(ednany, HashesSpreadSmallIntegers)
+{
+    // small integers hash to themselves in std::hash, which must not leak through
+    std::unordered_set<std::size_t> maps, sets;
+    std::size_t nsets = 0;
+    for(IntegerType i = 0; i < 200; ++i){
+        for(IntegerType j = 0; j < 200; ++j){
+            maps.insert(hashof(MapType{{StringType(U"x"), i}, {StringType(U"y"), j}}));
+            if(i < j){
+                sets.insert(hashof(SetType{i, j}));
+                ++nsets;
+            }
+        }
+    }
+    EXPECT_GE(maps.size(), 40000u - 4);
+    EXPECT_GE(sets.size(), nsets - 4);
+}
+
+TEST(ednany, SecondHashIsIndependent)
+{
+    // both hashes together must not collide where one of them does
+    std::set<std::pair<std::size_t, std::size_t>> both;
+    std::unordered_set<std::size_t> second;
+    for(IntegerType i = 0; i < 200; ++i){
+        for(IntegerType j = 0; j < 200; ++j){
+            MapType m{{StringType(U"x"), i}, {StringType(U"y"), j}};
+            EXPECT_EQ(hash2of(m), hash2of(MapType{{StringType(U"y"), j}, {StringType(U"x"), i}}));
+            second.insert(hash2of(m));
+            both.insert({hashof(m), hash2of(m)});
+        }
+    }
+    EXPECT_GE(second.size(), 40000u - 4);
+    EXPECT_EQ(both.size(), 40000u);
+}
@@ -0,0 +1,129 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <gtest/gtest.h>
+#include <edncxx/ednany.h>
+#include <edncxx/edncolumnar.h>
+using namespace edncxx;
+
+static KeywordType kw(const char32_t* name)
+{
+    return KeywordType{U"", name};
+}
+
+static MapType row(IntegerType id, ValueType name, ValueType score, ValueType extra)
+{
+    MapType m;
+    m.insert_or_assign(kw(U"id"), id);
+    m.insert_or_assign(kw(U"name"), std::move(name));
+    m.insert_or_assign(kw(U"score"), std::move(score));
+    m.insert_or_assign(kw(U"extra"), std::move(extra));
+    return m;
+}
+
+TEST(edncolumnar, TypedColumns)
+{
+    VectorType rows{
+        row(1, StringType{U"ann"}, FloatType{1.5}, BoolType{true}),
+        row(2, StringType{U"bob"}, NilType{}, kw(U"x")),
+        row(3, StringType{U"ann"}, FloatType{2.5}, NilType{}),
+    };
+    auto t = toColumnar(rows);
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t->rows, 3u);
+    ASSERT_EQ(t->columns.size(), 4u);
+
+    auto id = t->column(kw(U"id"));
+    ASSERT_TRUE(id);
+    EXPECT_EQ(id->type, ColumnType::Integer);
+    EXPECT_EQ(id->integers, (std::vector<IntegerType>{1, 2, 3}));
+
+    auto name = t->column(kw(U"name"));
+    EXPECT_EQ(name->type, ColumnType::String);
+    EXPECT_EQ(name->dictionary.size(), 2u);
+    EXPECT_EQ(name->codes, (std::vector<std::uint32_t>{0, 1, 0}));
+    EXPECT_EQ(std::any_cast<StringType>(name->at(2)), U"ann");
+
+    auto score = t->column(kw(U"score"));
+    EXPECT_EQ(score->type, ColumnType::Float);
+    EXPECT_FALSE(score->isNull(0));
+    EXPECT_TRUE(score->isNull(1));
+    EXPECT_TRUE(is<NilType>(score->at(1)));
+    EXPECT_EQ(score->floats[2], 2.5);
+
+    auto extra = t->column(kw(U"extra"));
+    EXPECT_EQ(extra->type, ColumnType::Value);
+    EXPECT_TRUE(std::any_cast<BoolType>(extra->at(0)));
+    EXPECT_TRUE(is<KeywordType>(extra->at(1)));
+    EXPECT_TRUE(extra->isNull(2));
+
+    EXPECT_FALSE(t->column(kw(U"missing")));
+}
+
+TEST(edncolumnar, MissingKeysAreNull)
+{
+    MapType a, b;
+    a.insert_or_assign(kw(U"a"), IntegerType{1});
+    b.insert_or_assign(kw(U"b"), kw(U"k"));
+    ListType rows{a, b};
+    auto t = toColumnar(rows);
+    ASSERT_TRUE(t);
+    auto ca = t->column(kw(U"a"));
+    auto cb = t->column(kw(U"b"));
+    EXPECT_FALSE(ca->isNull(0));
+    EXPECT_TRUE(ca->isNull(1));
+    EXPECT_TRUE(cb->isNull(0));
+    EXPECT_EQ(cb->type, ColumnType::Keyword);
+    EXPECT_TRUE(equals(cb->at(1), kw(U"k")));
+}
+
+TEST(edncolumnar, ManyRowsRoundTrip)
+{
+    VectorType rows;
+    for(IntegerType i = 0; i < 200; ++i)
+        rows.push_back(row(i, StringType(1, U'a' + i % 5), i % 3 ? ValueType{FloatType(i)} : ValueType{NilType{}}, NilType{}));
+    auto t = toColumnar(rows);
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t->column(kw(U"name"))->dictionary.size(), 5u);
+    EXPECT_EQ(t->column(kw(U"extra"))->type, ColumnType::Value);
+    auto i = 0u;
+    for(auto& r : rows){
+        auto& m = std::any_cast<const MapType&>(r);
+        for(auto& col : t->columns)
+            EXPECT_TRUE(equals(col.at(i), *m.find(col.name)));
+        ++i;
+    }
+}
+
+TEST(edncolumnar, NotTabular)
+{
+    EXPECT_FALSE(toColumnar(NilType{}));
+    EXPECT_FALSE(toColumnar(VectorType{IntegerType{1}}));
+    MapType m;
+    m.insert_or_assign(StringType{U"k"}, IntegerType{1});
+    EXPECT_FALSE(toColumnar(VectorType{m}));
+    auto t = toColumnar(VectorType{});
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t->rows, 0u);
+}
@@ -0,0 +1,239 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <edncxx/edndiff.h>
+#include <edncxx/ednreader.h>
+#include <edncxx/utf8reader.h>
+using namespace edncxx;
+
+static ValueType read(const std::string& text)
+{
+    std::istringstream strm(text);
+    Utf8Reader rdr(strm);
+    ReadOptions opts;
+    opts.hash = true;
+    return *readValue(rdr, opts);
+}
+
+static std::vector<Change> diffOf(const std::string& before, const std::string& after, const DiffOptions& opts = {})
+{
+    return diff(read(before), read(after), opts);
+}
+
+static ValueType s(const char32_t* text)
+{
+    return StringType{text};
+}
+
+static void expectPath(const Change& c, std::vector<ValueType> path)
+{
+    ASSERT_EQ(c.path.size(), path.size());
+    for(auto ix = 0u; ix < path.size(); ++ix)
+        EXPECT_TRUE(equals(c.path[ix], path[ix])) << ix;
+}
+
+TEST(edndiff, Identical)
+{
+    EXPECT_TRUE(diffOf(R"({"a" ["x" nil] "b" #{true}})", R"({"b" #{true} "a" ["x" nil]})").empty());
+    auto v = read(R"([{"a" nil}])");
+    EXPECT_TRUE(diff(v, v).empty());
+}
+
+TEST(edndiff, ChangedLeaf)
+{
+    auto d = diffOf(R"({"svc" [{"port" "80" "host" "a"}] "x" nil})",
+                    R"({"svc" [{"port" "81" "host" "a"}] "x" nil})");
+    ASSERT_EQ(d.size(), 1u);
+    EXPECT_EQ(d[0].kind, Change::Changed);
+    expectPath(d[0], {s(U"svc"), IntegerType{0}, s(U"port")});
+    EXPECT_TRUE(equals(d[0].before, s(U"80")));
+    EXPECT_TRUE(equals(d[0].after, s(U"81")));
+}
+
+TEST(edndiff, AddedAndRemovedKeys)
+{
+    auto d = diffOf(R"({"a" nil "b" true})", R"({"b" true "c" "new"})");
+    ASSERT_EQ(d.size(), 2u);
+    EXPECT_EQ(d[0].kind, Change::Removed);
+    expectPath(d[0], {s(U"a")});
+    EXPECT_FALSE(d[0].after.has_value());
+    EXPECT_EQ(d[1].kind, Change::Added);
+    expectPath(d[1], {s(U"c")});
+    EXPECT_TRUE(equals(d[1].after, s(U"new")));
+}
+
+TEST(edndiff, Sequences)
+{
+    auto d = diffOf(R"(["a" "b"])", R"(["a" "c" "d"])");
+    ASSERT_EQ(d.size(), 2u);
+    EXPECT_EQ(d[0].kind, Change::Changed);
+    expectPath(d[0], {IntegerType{1}});
+    EXPECT_EQ(d[1].kind, Change::Added);
+    expectPath(d[1], {IntegerType{2}});
+
+    d = diffOf(R"(("a" "b"))", R"(("a"))");
+    ASSERT_EQ(d.size(), 1u);
+    EXPECT_EQ(d[0].kind, Change::Removed);
+    expectPath(d[0], {IntegerType{1}});
+}
+
+TEST(edndiff, Sets)
+{
+    auto d = diffOf(R"({"s" #{"a" "b"}})", R"({"s" #{"b" "c"}})");
+    ASSERT_EQ(d.size(), 2u);
+    EXPECT_EQ(d[0].kind, Change::Removed);
+    expectPath(d[0], {s(U"s")});
+    EXPECT_TRUE(equals(d[0].before, s(U"a")));
+    EXPECT_EQ(d[1].kind, Change::Added);
+    EXPECT_TRUE(equals(d[1].after, s(U"c")));
+}
+
+TEST(edndiff, TypesAndTags)
+{
+    auto d = diffOf(R"(["a" [nil]])", R"(["a" {nil nil}])");
+    ASSERT_EQ(d.size(), 1u);
+    EXPECT_EQ(d[0].kind, Change::Changed);
+    expectPath(d[0], {IntegerType{1}});
+
+    d = diffOf(R"(#x ["a" "b"])", R"(#x ["a" "c"])");
+    ASSERT_EQ(d.size(), 1u);
+    expectPath(d[0], {IntegerType{1}});
+
+    d = diffOf(R"(#x ["a"])", R"(#y ["a"])");
+    ASSERT_EQ(d.size(), 1u);
+    EXPECT_TRUE(d[0].path.empty());
+    EXPECT_EQ(edntype(d[0].after), T_Tagged);
+}
+
+TEST(edndiff, ReadHashesCollections)
+{
+    auto v = read(R"([{"a" nil}])");
+    auto& vec = std::any_cast<const VectorType&>(v);
+    EXPECT_NE(vec.cachedHash(), 0u);
+    EXPECT_NE(std::any_cast<const MapType&>(vec[0]).cachedHash(), 0u);
+    EXPECT_NE(vec.cachedHash2(), 0u);
+    EXPECT_NE(std::any_cast<const MapType&>(vec[0]).cachedHash2(), 0u);
+}
+
+TEST(edndiff, SharedSubtrees)
+{
+    VectorType inner{s(U"a"), s(U"b")};
+    VectorType a{inner, s(U"x")};
+    VectorType b{inner, s(U"y")};
+    auto d = diff(a, b);
+    ASSERT_EQ(d.size(), 1u);
+    expectPath(d[0], {IntegerType{1}});
+}
+
+TEST(edndiff, Parallel)
+{
+    std::string before = "[", after = "[";
+    for(int ix = 0; ix < 500; ++ix){
+        auto name = "\"n" + std::to_string(ix) + "\"";
+        before += "{\"name\" " + name + " \"on\" true}";
+        after += "{\"name\" " + name + " \"on\" " + (ix % 97 ? "true" : "false") + "}";
+    }
+    before += "]";
+    after += "]";
+    DiffOptions serial, parallel;
+    parallel.parallelThreshold = 16;
+    auto a = diffOf(before, after, serial);
+    auto b = diffOf(before, after, parallel);
+    ASSERT_EQ(a.size(), 6u);
+    ASSERT_EQ(b.size(), a.size());
+    for(auto ix = 0u; ix < a.size(); ++ix){
+        expectPath(b[ix], a[ix].path);
+        expectPath(a[ix], {IntegerType(97 * ix), s(U"on")});
+    }
+}
+
+// the reader has no integers yet, these are built directly
+static MapType pair(const char32_t* k1, IntegerType v1, const char32_t* k2, IntegerType v2)
+{
+    return MapType{{s(k1), v1}, {s(k2), v2}};
+}
+
+TEST(edndiff, IntegerPayloads)
+{
+    auto d = diff(VectorType{pair(U"x", 1, U"y", 2)}, VectorType{pair(U"x", 0, U"y", 17)});
+    ASSERT_EQ(d.size(), 2u);
+    expectPath(d[0], {IntegerType{0}, s(U"x")});
+    expectPath(d[1], {IntegerType{0}, s(U"y")});
+
+    d = diff(SetType{IntegerType{1}, IntegerType{2}}, SetType{IntegerType{0}, IntegerType{3}});
+    EXPECT_EQ(d.size(), 4u);
+
+    // every variant of a small config differs from the original but one
+    auto base = pair(U"port", 8080, U"workers", 4);
+    std::size_t missed = 0, spurious = 0;
+    for(IntegerType port = 8000; port < 8200; ++port){
+        for(IntegerType workers = 0; workers < 16; ++workers){
+            auto variant = pair(U"port", port, U"workers", workers);
+            auto changes = diff(base, variant).size();
+            auto expect = std::size_t(port != 8080) + std::size_t(workers != 4);
+            missed += changes < expect;
+            spurious += changes > expect;
+        }
+    }
+    EXPECT_EQ(missed, 0u);
+    EXPECT_EQ(spurious, 0u);
+}
+
+TEST(edndiff, EqualHashesAreTrusted)
+{
+    // force a collision through both memos: it is taken as equal without a
+    // walk, and only verify finds the change
+    VectorType a{s(U"a"), pair(U"x", 1, U"y", 2)};
+    VectorType b{s(U"a"), pair(U"x", 1, U"y", 3)};
+    for(auto* v : {&a, &b}){
+        v->cacheHash(42);
+        v->cacheHash2(43);
+        std::any_cast<const MapType&>((*v)[1]).cacheHash(7);
+        std::any_cast<const MapType&>((*v)[1]).cacheHash2(8);
+    }
+    EXPECT_TRUE(diff(a, b).empty());
+
+    DiffOptions opts;
+    opts.verify = true;
+    auto d = diff(a, b, opts);
+    ASSERT_EQ(d.size(), 1u);
+    expectPath(d[0], {IntegerType{1}, s(U"y")});
+}
+
+TEST(edndiff, EitherHashSeparates)
+{
+    // a collision on one hash alone is still seen as a difference
+    VectorType a{s(U"a"), pair(U"x", 1, U"y", 2)};
+    VectorType b{s(U"a"), pair(U"x", 1, U"y", 3)};
+    a.cacheHash(42);
+    b.cacheHash(42);
+    std::any_cast<const MapType&>(a[1]).cacheHash(7);
+    std::any_cast<const MapType&>(b[1]).cacheHash(7);
+    auto d = diff(a, b);
+    ASSERT_EQ(d.size(), 1u);
+    expectPath(d[0], {IntegerType{1}, s(U"y")});
+}
+
@@ -0,0 +1,85 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <edncxx/ednany.h>
+#include <edncxx/ednfootprint.h>
+using namespace edncxx;
+
+TEST(ednfootprint, Scalars)
+{
+    VectorType v{IntegerType{1}, IntegerType{2}, BoolType{true}};
+    auto fp = footprint(v);
+    EXPECT_EQ(fp[T_Integer].count, 2u);
+    EXPECT_EQ(fp[T_Integer].payload, 2 * sizeof(IntegerType));
+    EXPECT_EQ(fp[T_Integer].bytes(), 2 * sizeof(ValueType));
+    EXPECT_EQ(fp[T_Integer].allocations, 0u);
+    EXPECT_EQ(fp[T_Vector].count, 1u);
+    EXPECT_EQ(fp[T_Vector].allocations, 1u);
+    EXPECT_EQ(fp.total().bytes(), v.allocated());
+    EXPECT_FALSE(fp.sampled);
+}
+
+TEST(ednfootprint, Strings)
+{
+    StringType text(U"a long enough string to leave the object");
+    text.reserve(100);
+    VectorType v;
+    v.push_back(std::move(text));
+    v.push_back(StringType(U"ab"));
+    auto& held = std::any_cast<const StringType&>(v[0]);
+    auto fp = footprint(v);
+    auto& s = fp[T_String];
+    EXPECT_EQ(s.count, 2u);
+    EXPECT_EQ(s.payload, (held.size() + 2) * sizeof(char32_t));
+    EXPECT_EQ(s.slack, (held.capacity() - held.size()) * sizeof(char32_t));
+    EXPECT_EQ(s.allocations, 3u);    // two boxes, one buffer
+}
+
+TEST(ednfootprint, SharedNodesCountOnce)
+{
+    VectorType inner{IntegerType{1}, IntegerType{2}};
+    VectorType outer{inner, inner, inner};
+    auto fp = footprint(outer);
+    EXPECT_EQ(fp[T_Vector].count, 4u);
+    EXPECT_EQ(fp[T_Vector].allocations, 2u);
+    EXPECT_EQ(fp[T_Integer].count, 2u);
+}
+
+TEST(ednfootprint, SampledEstimate)
+{
+    VectorType rows;
+    for(int ix = 0; ix < 10000; ++ix)
+        rows.push_back(MapType{{StringType(U"id"), IntegerType{ix}}, {StringType(U"ok"), BoolType{true}}});
+
+    auto exact = footprint(rows);
+    auto estimate = footprint(rows, 0.01);
+    EXPECT_TRUE(estimate.sampled);
+    EXPECT_EQ(estimate[T_Map].count, exact[T_Map].count);
+    EXPECT_NEAR(double(estimate.total().bytes()), double(exact.total().bytes()), exact.total().bytes() * 0.01);
+
+    std::ostringstream report;
+    report << estimate;
+    EXPECT_NE(report.str().find("~Total"), std::string::npos);
+}
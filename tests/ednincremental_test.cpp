@@ -0,0 +1,130 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <edncxx/ednincremental.h>
+#include <edncxx/utf8reader.h>
+using namespace edncxx;
+
+// what a full read of the same text gives
+static std::vector<ValueType> readAll(const std::string& text)
+{
+    std::istringstream strm(text);
+    Utf8Reader rdr(strm);
+    std::vector<ValueType> result;
+    while(auto v = readValue(rdr))
+        result.push_back(std::move(*v));
+    return result;
+}
+
+static void expectConsistent(const IncrementalDocument& doc)
+{
+    auto full = readAll(doc.text());
+    ASSERT_EQ(doc.forms().size(), full.size());
+    std::size_t at = 0;
+    for(auto ix = 0u; ix < full.size(); ++ix){
+        auto& form = doc.forms()[ix];
+        EXPECT_EQ(form.begin, at);
+        EXPECT_TRUE(equals(form.value, full[ix])) << ix;
+        at = form.end;
+    }
+}
+
+static std::string document(int forms)
+{
+    std::string text;
+    for(int ix = 0; ix < forms; ++ix)
+        text += "[\"form" + std::to_string(ix) + "\" {\"k\" nil}] ; comment\n";
+    return text;
+}
+
+TEST(ednincremental, EditInsideOneForm)
+{
+    IncrementalDocument doc(document(100));
+    EXPECT_EQ(doc.lastReparsed(), 100u);
+    auto before = doc.forms();
+
+    auto at = doc.text().find("form42") + 4;
+    doc.edit(at, 2, "XX42");
+    EXPECT_EQ(doc.lastReparsed(), 1u);
+    expectConsistent(doc);
+
+    auto& v = std::any_cast<const VectorType&>(doc.forms()[42].value);
+    EXPECT_EQ(std::any_cast<StringType>(v[0]), U"formXX42");
+    // the rest are the very same nodes
+    for(auto ix : {0, 41, 43, 99})
+        EXPECT_TRUE(std::any_cast<const VectorType&>(doc.forms()[ix].value)
+                    .shares(std::any_cast<const VectorType&>(before[ix].value)));
+}
+
+TEST(ednincremental, InsertAndRemoveForms)
+{
+    IncrementalDocument doc(document(10));
+    auto at = doc.forms()[3].end;
+    doc.edit(at, 0, " true false ");
+    EXPECT_EQ(doc.forms().size(), 12u);
+    expectConsistent(doc);
+
+    // drop forms 4 and 5 again
+    doc.edit(doc.forms()[4].begin, doc.forms()[5].end - doc.forms()[4].begin, "");
+    EXPECT_EQ(doc.forms().size(), 10u);
+    expectConsistent(doc);
+
+    doc.edit(doc.text().size(), 0, "nil");
+    EXPECT_EQ(doc.forms().size(), 11u);
+    expectConsistent(doc);
+}
+
+TEST(ednincremental, EditsThatChangeTokens)
+{
+    IncrementalDocument doc("nil true [nil] \"a b\" false");
+    // "xtrue" does not read, the edit throws
+    EXPECT_THROW(doc.edit(4, 0, "x"), std::runtime_error);
+    // after a failed edit the next one re-reads everything
+    doc.edit(4, 1, "");
+    EXPECT_EQ(doc.lastReparsed(), 5u);
+    expectConsistent(doc);
+
+    // an opening quote swallows the following forms until it is closed
+    IncrementalDocument doc2("[nil] \"x\" true");
+    EXPECT_THROW(doc2.edit(0, 0, "\""), std::runtime_error);
+    doc2.edit(0, 1, "\"\" ");
+    expectConsistent(doc2);
+    EXPECT_EQ(doc2.forms().size(), 4u);
+}
+
+TEST(ednincremental, EditsAtEndOfText)
+{
+    // a comment or an open string running into the end of the text
+    IncrementalDocument doc("nil\n");
+    doc.edit(4, 0, "; note");
+    EXPECT_EQ(doc.text(), "nil\n; note");
+    EXPECT_EQ(doc.forms().size(), 1u);
+    expectConsistent(doc);
+
+    EXPECT_THROW(doc.edit(4, 0, "\"open "), std::runtime_error);
+    doc.edit(4, 6, "\"closed\" ");
+    EXPECT_EQ(doc.forms().size(), 2u);
+    expectConsistent(doc);
+}
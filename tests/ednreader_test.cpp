@@ -21,10 +21,15 @@
 // THE SOFTWARE.
 
 #include <gtest/gtest.h>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <unordered_set>
 #include <edncxx/utf8reader.h>
 #include <edncxx/ednreader.h>
 #include <edncxx/ednany.h>
+#include <edncxx/edndedup.h>
+#include <edncxx/ednrelease.h>
 using namespace edncxx;
 using namespace std;
 
@@ -79,3 +84,257 @@ TEST(ednreader, string)
     EXPECT_EQ(edntype(*ss), EdnType::T_String);
     EXPECT_EQ(std::any_cast<StringType>(*ss), ans2);
 }
+
+TEST(ednreader, collections)
+{
+    std::istringstream strm("(nil true) [\"a\" ; comment\n false] {\"k\" nil} #{true false}");
+    Utf8Reader rdr(strm);
+
+    auto lst = readValue(rdr);
+    ASSERT_TRUE(lst);
+    EXPECT_EQ(edntype(*lst), EdnType::T_List);
+    EXPECT_EQ(std::any_cast<const ListType&>(*lst).size(), 2u);
+
+    auto vec = readValue(rdr);
+    ASSERT_TRUE(vec);
+    EXPECT_EQ(edntype(*vec), EdnType::T_Vector);
+    auto& v = std::any_cast<const VectorType&>(*vec);
+    ASSERT_EQ(v.size(), 2u);
+    EXPECT_EQ(std::any_cast<StringType>(v[0]), U"a");
+    EXPECT_EQ(std::any_cast<BoolType>(v[1]), false);
+
+    auto map = readValue(rdr);
+    ASSERT_TRUE(map);
+    EXPECT_EQ(edntype(*map), EdnType::T_Map);
+    auto& m = std::any_cast<const MapType&>(*map);
+    ASSERT_TRUE(m.find(StringType(U"k")));
+    EXPECT_TRUE(is<NilType>(*m.find(StringType(U"k"))));
+
+    auto set = readValue(rdr);
+    ASSERT_TRUE(set);
+    EXPECT_EQ(edntype(*set), EdnType::T_Set);
+    EXPECT_TRUE(std::any_cast<const SetType&>(*set).contains(BoolType{true}));
+    EXPECT_FALSE(readValue(rdr));
+}
+
+TEST(ednreader, nestedAndEmpty)
+{
+    std::istringstream strm("[[] () {} [[nil]]]");
+    Utf8Reader rdr(strm);
+    auto val = readValue(rdr);
+    ASSERT_TRUE(val);
+    auto& v = std::any_cast<const VectorType&>(*val);
+    ASSERT_EQ(v.size(), 4u);
+    EXPECT_TRUE(std::any_cast<const VectorType&>(v[0]).empty());
+    EXPECT_TRUE(std::any_cast<const ListType&>(v[1]).empty());
+    EXPECT_TRUE(std::any_cast<const MapType&>(v[2]).empty());
+    auto& inner = std::any_cast<const VectorType&>(v[3]);
+    EXPECT_TRUE(is<NilType>(std::any_cast<const VectorType&>(inner[0])[0]));
+}
+
+TEST(ednreader, largeMapIsHashed)
+{
+    std::string text("{");
+    for(int ix = 0; ix < 20; ++ix)
+        text += "\"k" + std::to_string(ix) + "\" " + (ix % 2 ? "true " : "false ");
+    text += "}";
+    std::istringstream strm(text);
+    Utf8Reader rdr(strm);
+    auto val = readValue(rdr);
+    ASSERT_TRUE(val);
+    auto& m = std::any_cast<const MapType&>(*val);
+    EXPECT_EQ(m.size(), 20u);
+    EXPECT_TRUE(m.hashed());
+    EXPECT_EQ(std::any_cast<BoolType>(m.at(StringType(U"k7"))), true);
+}
+
+TEST(ednreader, malformedCollections)
+{
+    auto fails = [](const std::string& text){
+        std::istringstream strm(text);
+        Utf8Reader rdr(strm);
+        EXPECT_THROW(readValue(rdr), std::runtime_error) << text;
+    };
+    fails("[nil");
+    fails("{nil}");
+    fails("{nil true nil false}");
+    fails("#{nil nil}");
+}
+
+TEST(ednreader, dedupSharesEqualSubtrees)
+{
+    std::string text("[");
+    for(int ix = 0; ix < 100; ++ix)
+        text += "{\"unit\" \"metre\" \"si\" true} ";
+    text += "]";
+
+    DedupTable table;
+    ReadOptions opts;
+    opts.dedup = &table;
+    std::istringstream strm(text);
+    Utf8Reader rdr(strm);
+    auto val = readValue(rdr, opts);
+    ASSERT_TRUE(val);
+
+    auto& v = std::any_cast<const VectorType&>(*val);
+    ASSERT_EQ(v.size(), 100u);
+    auto& first = std::any_cast<const MapType&>(v[0]);
+    for(auto& item : v)
+        EXPECT_TRUE(first.shares(std::any_cast<const MapType&>(item)));
+    EXPECT_EQ(table.hits(), 99u);
+    EXPECT_GT(table.bytesSaved(), 99 * first.allocated());
+
+    // a second document reuses the entries, pruning keeps live ones only
+    std::istringstream again("{\"si\" true \"unit\" \"metre\"}");
+    Utf8Reader rdr2(again);
+    auto other = readValue(rdr2, opts);
+    ASSERT_TRUE(other);
+    EXPECT_TRUE(first.shares(std::any_cast<const MapType&>(*other)));
+
+    val.reset();
+    other.reset();
+    table.prune();
+    EXPECT_EQ(table.size(), 0u);
+}
+
+TEST(ednreader, dedupSpreadsIntegerMaps)
+{
+    // the reader has no integers yet, so the maps are built directly
+    DedupTable table;
+    std::vector<ValueType> kept;
+    for(IntegerType i = 0; i < 200; ++i)
+        for(IntegerType j = 0; j < 200; ++j)
+            kept.push_back(table.intern(MapType{{StringType(U"x"), i}, {StringType(U"y"), j}}));
+    EXPECT_EQ(table.size(), 40000u);
+    EXPECT_EQ(table.hits(), 0u);
+    table.intern(MapType{{StringType(U"y"), IntegerType{7}}, {StringType(U"x"), IntegerType{3}}});
+    EXPECT_EQ(table.hits(), 1u);
+
+    // same hashing the table uses, no bucket may turn into a long chain
+    std::unordered_set<ValueType, ValueHash, ValueEqual> buckets(kept.begin(), kept.end());
+    std::size_t longest = 0;
+    for(std::size_t b = 0; b < buckets.bucket_count(); ++b)
+        longest = std::max(longest, buckets.bucket_size(b));
+    EXPECT_LE(longest, 12u);
+}
+
+TEST(ednreader, dedupKeepsFloatBits)
+{
+    // equal under ==, but sharing would turn one into the other
+    DedupTable table;
+    auto pos = table.intern(VectorType{FloatType{0.0}});
+    auto neg = table.intern(VectorType{FloatType{-0.0}});
+    EXPECT_EQ(table.hits(), 0u);
+    EXPECT_FALSE(std::any_cast<const VectorType&>(pos).shares(std::any_cast<const VectorType&>(neg)));
+    EXPECT_TRUE(std::signbit(std::any_cast<FloatType>(std::any_cast<const VectorType&>(neg)[0])));
+
+    // never equal to itself under ==, yet the same bits
+    auto nan = std::numeric_limits<FloatType>::quiet_NaN();
+    auto first = table.intern(VectorType{nan});
+    auto second = table.intern(VectorType{nan});
+    EXPECT_EQ(table.hits(), 1u);
+    EXPECT_TRUE(std::any_cast<const VectorType&>(first).shares(std::any_cast<const VectorType&>(second)));
+
+    table.intern(MapType{{StringType(U"x"), nan}, {FloatType{-0.0}, NilType{}}});
+    table.intern(MapType{{FloatType{-0.0}, NilType{}}, {StringType(U"x"), nan}});
+    table.intern(MapType{{FloatType{0.0}, NilType{}}, {StringType(U"x"), nan}});
+    EXPECT_EQ(table.hits(), 2u);
+    EXPECT_EQ(table.size(), 5u);
+}
+
+TEST(ednreader, taggedAndDiscard)
+{
+    std::istringstream strm("#_ nil #my/tag [#_ \"gone\" true] #point #_ false {\"x\" nil} #_ [nil nil]");
+    Utf8Reader rdr(strm);
+
+    auto tagged = readValue(rdr);
+    ASSERT_TRUE(tagged);
+    ASSERT_EQ(edntype(*tagged), EdnType::T_Tagged);
+    auto& t = std::any_cast<const TaggedType&>(*tagged);
+    EXPECT_EQ(t.ns, U"my");
+    EXPECT_EQ(t.tag, U"tag");
+    EXPECT_EQ(std::any_cast<const VectorType&>(t.rep).size(), 1u);
+
+    auto point = readValue(rdr);
+    ASSERT_TRUE(point);
+    auto& p = std::any_cast<const TaggedType&>(*point);
+    EXPECT_EQ(p.ns, U"");
+    EXPECT_EQ(p.tag, U"point");
+    EXPECT_EQ(edntype(p.rep), EdnType::T_Map);
+
+    EXPECT_FALSE(readValue(rdr));
+}
+
+static std::string nested(std::size_t depth)
+{
+    return std::string(depth, '[') + "nil" + std::string(depth, ']');
+}
+
+TEST(ednreader, deepNestingIsIterative)
+{
+    std::istringstream strm(nested(100000));
+    Utf8Reader rdr(strm);
+    ReadOptions opts;
+    opts.maxDepth = 100000;
+    auto val = readValue(rdr, opts);
+    ASSERT_TRUE(val);
+    std::size_t depth = 0;
+    const ValueType* at = &*val;
+    while(is<VectorType>(*at)){
+        at = &std::any_cast<const VectorType&>(*at)[0];
+        ++depth;
+    }
+    EXPECT_EQ(depth, 100000u);
+    release(std::move(*val));
+}
+
+TEST(ednreader, maxDepthFailsCleanly)
+{
+    ReadOptions opts;
+    opts.maxDepth = 64;
+    std::istringstream strm(nested(65) + " [true]");
+    Utf8Reader rdr(strm);
+    EXPECT_THROW(readValue(rdr, opts), std::runtime_error);
+
+    // the per-thread stacks are reset, the reader is not rewound: it is left
+    // just past the '[' that went too deep, so reading on starts inside the
+    // rejected form and the closers that follow are unmatched
+    EXPECT_EQ(rdr.offset(), 65u);
+    auto inner = readValue(rdr, opts);
+    ASSERT_TRUE(inner);
+    EXPECT_TRUE(is<NilType>(*inner));
+    EXPECT_THROW(readValue(rdr, opts), std::runtime_error);
+
+    // a fresh form at full depth reads fine on the same thread
+    std::istringstream ok(nested(64));
+    Utf8Reader rdr2(ok);
+    EXPECT_TRUE(readValue(rdr2, opts));
+}
+
+TEST(ednreader, defaultDepthIsSafeToDestroy)
+{
+    // the default limit keeps plain destruction within a 1 MiB stack
+    std::istringstream deep(nested(1000));
+    Utf8Reader rdr(deep);
+    auto val = readValue(rdr);
+    ASSERT_TRUE(val);
+    val.reset();
+
+    std::istringstream deeper(nested(1001));
+    Utf8Reader rdr2(deeper);
+    EXPECT_THROW(readValue(rdr2), std::runtime_error);
+}
+
+TEST(ednreader, unmatchedDelimiters)
+{
+    auto fails = [](const std::string& text){
+        std::istringstream strm(text);
+        Utf8Reader rdr(strm);
+        EXPECT_THROW(readValue(rdr), std::runtime_error) << text;
+    };
+    fails("]");
+    fails("[nil)");
+    fails("(nil}");
+    fails("#my/tag");
+    fails("#1 nil");
+}
@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <gtest/gtest.h>
+#include <edncxx/ednany.h>
+#include <edncxx/ednrelease.h>
+using namespace edncxx;
+
+// deep enough that recursive destructors would run off the stack
+static ValueType deepVector(int depth)
+{
+    ValueType v = VectorType{StringType(U"leaf")};
+    for(int ix = 0; ix < depth; ++ix)
+        v = VectorType{std::move(v), MapType{{IntegerType{ix}, TaggedType{U"", U"t", NilType{}}}}};
+    return v;
+}
+
+TEST(ednrelease, DeepTreeNow)
+{
+    auto v = deepVector(500000);
+    release(std::move(v));
+    SUCCEED();
+}
+
+TEST(ednrelease, SharedSubtreesSurvive)
+{
+    VectorType shared{StringType(U"keep")};
+    ValueType doc = VectorType{shared, shared};
+    release(std::move(doc));
+    ASSERT_EQ(shared.size(), 1u);
+    EXPECT_EQ(std::any_cast<StringType>(shared[0]), U"keep");
+    EXPECT_EQ(shared.useCount(), 1u);
+}
+
+TEST(ednrelease, Background)
+{
+    for(int ix = 0; ix < 4; ++ix)
+        release(deepVector(100000), Reclaim::Background);
+    flushReclaimer();
+    SUCCEED();
+}
+
+TEST(ednrelease, RecycleFeedsNextAllocation)
+{
+    trimNodeCache();
+    release(deepVector(1000), Reclaim::Recycle);
+    auto cached = cachedNodeBytes();
+    EXPECT_GT(cached, 0u);
+
+    auto again = deepVector(100);
+    EXPECT_LT(cachedNodeBytes(), cached);
+    release(std::move(again));
+    trimNodeCache();
+    EXPECT_EQ(cachedNodeBytes(), 0u);
+}
@@ -0,0 +1,264 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 Clay Hopperdietzel (aka Gnurdle)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <edncxx/ednreader.h>
+#include <edncxx/ednschema.h>
+#include <edncxx/utf8reader.h>
+using namespace edncxx;
+
+static std::optional<ValueType> readWith(const std::string& text, const Schema& schema)
+{
+    std::istringstream strm(text);
+    Utf8Reader rdr(strm);
+    ReadOptions opts;
+    opts.schema = &schema;
+    return readValue(rdr, opts);
+}
+
+static SchemaError rejected(const std::string& text, const Schema& schema)
+{
+    try{
+        readWith(text, schema);
+    }
+    catch(const SchemaError& e){
+        return e;
+    }
+    ADD_FAILURE() << "accepted: " << text;
+    return SchemaError("", "", 0);
+}
+
+// [{"id" string, "ok" bool, "note" string-or-nil}], no other keys
+static Schema people()
+{
+    Schema s;
+    auto str = s.scalar(T_String);
+    auto person = s.record({{StringType{U"id"}, str},
+                            {StringType{U"ok"}, s.scalar(T_Bool)},
+                            {StringType{U"note"}, s.nullable(str), false}}, true);
+    s.root(s.vector(person));
+    return s;
+}
+
+TEST(ednschema, Accepts)
+{
+    auto schema = people();
+    auto v = readWith(R"([{"id" "a" "ok" true} {"note" nil "ok" false "id" "b"}])", schema);
+    ASSERT_TRUE(v);
+    EXPECT_EQ(std::any_cast<const VectorType&>(*v).size(), 2u);
+}
+
+TEST(ednschema, WrongType)
+{
+    const std::string text = R"([{"id" "a" "ok" true} {"id" "b" "ok" "yes"}])";
+    auto e = rejected(text, people());
+    EXPECT_EQ(e.path(), R"([1 "ok"])");
+    EXPECT_EQ(e.offset(), text.find("\"yes\""));
+    EXPECT_NE(std::string(e.what()).find("expected Bool, got String"), std::string::npos) << e.what();
+}
+
+TEST(ednschema, MissingRequiredKey)
+{
+    const std::string text = R"([{"id" "a" "note" "n"}])";
+    auto e = rejected(text, people());
+    EXPECT_EQ(e.path(), "[0]");
+    EXPECT_EQ(e.offset(), text.find('}'));
+    EXPECT_NE(std::string(e.what()).find("\"ok\""), std::string::npos) << e.what();
+}
+
+TEST(ednschema, UnexpectedKey)
+{
+    const std::string text = R"([{"id" "a" "x" nil "ok" true}])";
+    auto e = rejected(text, people());
+    EXPECT_EQ(e.path(), "[0 <key>]");
+    EXPECT_EQ(e.offset(), text.find("\"x\""));
+}
+
+TEST(ednschema, RepeatedKey)
+{
+    // a repeat must not count for the required key that is missing
+    const std::string text = R"([{"id" "a" "id" "b"}])";
+    auto e = rejected(text, people());
+    EXPECT_EQ(e.path(), "[0 <key>]");
+    EXPECT_EQ(e.offset(), text.find(R"("id" "b")"));
+    EXPECT_NE(std::string(e.what()).find("duplicate key \"id\""), std::string::npos) << e.what();
+}
+
+TEST(ednschema, OpenRecordTakesOtherKeys)
+{
+    Schema s;
+    s.root(s.record({{StringType{U"id"}, s.scalar(T_String)}}));
+    EXPECT_TRUE(readWith(R"({"id" "a" "x" [nil]})", s));
+}
+
+TEST(ednschema, StopsAtFirstOffendingByte)
+{
+    // the rest is never read, so its missing closers go unnoticed
+    Schema s;
+    s.root(s.vector(s.scalar(T_String)));
+    const std::string text = R"(["a" "b" ("c" [[[)";
+    auto e = rejected(text, s);
+    EXPECT_EQ(e.offset(), text.find('('));
+    EXPECT_EQ(e.path(), "[2]");
+}
+
+TEST(ednschema, Collections)
+{
+    Schema s;
+    auto b = s.scalar(T_Bool);
+    s.root(s.list({s.set(b)}));
+    EXPECT_TRUE(readWith("(#{true false} #{})", s));
+    EXPECT_EQ(rejected("(#{true} [true])", s).path(), "[1]");
+    EXPECT_EQ(rejected("(#{true nil})", s).path(), "[0 1]");
+
+    Schema m;
+    m.root(m.map(m.scalar(T_String), m.nullable(m.scalar(T_Bool))));
+    EXPECT_TRUE(readWith(R"({"a" true "b" nil})", m));
+    EXPECT_EQ(rejected(R"({"a" true nil true})", m).path(), "[<key>]");
+    EXPECT_EQ(rejected(R"({"a" true "b" "c"})", m).path(), R"(["b"])");
+}
+
+TEST(ednschema, Tagged)
+{
+    Schema s;
+    s.root(s.tagged(U"", U"inst", s.scalar(T_String)));
+    EXPECT_TRUE(readWith(R"(#inst "1985-04-12")", s));
+    auto e = rejected(R"(#uuid "x")", s);
+    EXPECT_EQ(e.offset(), 0u);
+    EXPECT_NE(std::string(e.what()).find("expected #inst, got #uuid"), std::string::npos) << e.what();
+    e = rejected("#inst nil", s);
+    EXPECT_EQ(e.path(), "[#inst]");
+    EXPECT_EQ(e.offset(), 6u);
+}
+
+TEST(ednschema, DiscardedFormsAreNotChecked)
+{
+    Schema s;
+    s.root(s.vector(s.scalar(T_String)));
+    EXPECT_TRUE(readWith(R"([#_ nil "a" #_ {nil nil}])", s));
+}
+
+TEST(ednschema, AnyByDefault)
+{
+    Schema s;
+    EXPECT_TRUE(readWith(R"([nil {"a" #x (true)}])", s));
+}
+
+TEST(ednschema, BuilderErrors)
+{
+    Schema s;
+    EXPECT_THROW(s.scalar(T_List), std::runtime_error);
+    EXPECT_THROW(s.vector(42), std::runtime_error);
+    EXPECT_THROW(s.record({{StringType{U"a"}, s.any()}, {StringType{U"a"}, s.any()}}), std::runtime_error);
+}
+
+TEST(ednschema, ValidateOnly)
+{
+    auto schema = people();
+    std::istringstream strm(R"([{"id" "a" "ok" true}] [{"id" "b" "ok" false "note" "n"}])");
+    Utf8Reader rdr(strm);
+    ReadOptions opts;
+    opts.schema = &schema;
+    opts.validateOnly = true;
+    for(int ix = 0; ix < 2; ++ix){
+        auto v = readValue(rdr, opts);
+        ASSERT_TRUE(v);
+        EXPECT_TRUE(is<NilType>(*v));
+    }
+    EXPECT_FALSE(readValue(rdr, opts));
+
+    // the same violations, at the same places
+    for(auto text : {std::string(R"([{"id" "a" "ok" true} {"id" "b" "ok" "yes"}])"),
+                     std::string(R"([{"id" "a" "note" "n"}])"),
+                     std::string(R"([{"id" "a" "x" nil "ok" true}])"),
+                     std::string(R"([{"id" "a" "id" "b"}])")}){
+        auto full = rejected(text, schema);
+        std::istringstream again(text);
+        Utf8Reader rdr2(again);
+        try{
+            readValue(rdr2, opts);
+            ADD_FAILURE() << "accepted: " << text;
+        }
+        catch(const SchemaError& e){
+            EXPECT_EQ(e.path(), full.path());
+            EXPECT_EQ(e.offset(), full.offset());
+        }
+    }
+
+    // without a schema it is a syntax check
+    std::istringstream bad(R"({"a" nil "b"})");
+    Utf8Reader rdr3(bad);
+    ReadOptions syntax;
+    syntax.validateOnly = true;
+    EXPECT_THROW(readValue(rdr3, syntax), std::runtime_error);
+}
+
+TEST(ednschema, LargeRecordsHashKeys)
+{
+    // past a few fields keys are found by a search on their hash
+    Schema s;
+    std::vector<Schema::Field> fields;
+    for(int ix = 0; ix < 12; ++ix){
+        auto name = "f" + std::to_string(ix);
+        fields.push_back({StringType(name.begin(), name.end()), s.scalar(T_Bool), ix % 2 == 0});
+    }
+    auto rec = s.record(std::move(fields), true);
+    s.root(rec);
+    const std::string required = R"("f0" true "f2" true "f4" true "f6" true "f8" true "f10" )";
+    EXPECT_TRUE(readWith("{" + required + R"(true "f11" false})", s));
+    EXPECT_EQ(rejected("{" + required + "nil}", s).path(), R"(["f10"])");
+    EXPECT_EQ(rejected("{" + required + R"(true "f12" true})", s).path(), "[<key>]");
+
+    ASSERT_TRUE(s.field(rec, StringType{U"f7"}));
+    EXPECT_FALSE(s.field(rec, StringType{U"f7"})->required);
+    EXPECT_FALSE(s.field(rec, KeywordType{U"", U"f7"}));
+
+    std::vector<Schema::Field> many;
+    for(int ix = 0; ix < 100; ++ix)
+        many.push_back({IntegerType{ix * 7}, s.scalar(T_Nil), false});
+    auto big = s.record(std::move(many));
+    for(int ix = 0; ix < 100; ++ix){
+        auto f = s.field(big, IntegerType{ix * 7});
+        ASSERT_TRUE(f) << ix;
+        EXPECT_TRUE(equals(f->key, IntegerType{ix * 7}));
+    }
+    EXPECT_FALSE(s.field(big, IntegerType{1}));
+}
+
+TEST(ednschema, KeywordFields)
+{
+    // the reader has no keywords yet, the lookup is what it would use
+    Schema s;
+    auto rec = s.record({{KeywordType{U"", U"id"}, s.scalar(T_String)},
+                         {KeywordType{U"user", U"id"}, s.scalar(T_Bool)}});
+    auto plain = s.field(rec, KeywordType{U"", U"id"});
+    auto user = s.field(rec, KeywordType{U"user", U"id"});
+    ASSERT_TRUE(plain);
+    ASSERT_TRUE(user);
+    EXPECT_NE(plain, user);
+    EXPECT_EQ(s.node(user->value).kind, T_Bool);
+    EXPECT_FALSE(s.field(rec, KeywordType{U"", U"name"}));
+    EXPECT_FALSE(s.field(rec, StringType{U"id"}));
+}
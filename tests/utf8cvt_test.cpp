@@ -64,3 +64,84 @@ TEST(utf8cvt, TwoWayString)
     EXPECT_EQ(edncxx::decodeUtf8(s8), s32);
 }
 
+TEST(utf8cvt, Lengths)
+{
+    std::u32string s32 = {0x0024, 0x00a2, 0x0939, 0x20ac, 0xd55c, 0x10348};
+    std::string s8 = "\x24\xc2\xa2\xe0\xa4\xb9\xe2\x82\xac\xed\x95\x9c\xf0\x90\x8d\x88";
+
+    EXPECT_EQ(utf8LengthOf(s32), s8.size());
+    EXPECT_EQ(utf32LengthOf(s8), s32.size());
+    EXPECT_EQ(utf16LengthOf(s8), 7u);
+    EXPECT_EQ(utf16LengthOf(s32), 7u);
+}
+
+TEST(utf8cvt, IntoBuffer)
+{
+    std::u32string s32 = {0x0024, 0x00a2, 0x0939, 0x20ac, 0xd55c, 0x10348};
+    std::string s8 = "\x24\xc2\xa2\xe0\xa4\xb9\xe2\x82\xac\xed\x95\x9c\xf0\x90\x8d\x88";
+
+    char out8[32];
+    auto rc = encodeUtf8(s32, out8, sizeof(out8));
+    EXPECT_TRUE(rc.ok);
+    EXPECT_EQ(rc.read, s32.size());
+    EXPECT_EQ(std::string(out8, rc.written), s8);
+
+    char32_t out32[16];
+    rc = decodeUtf8(s8, out32, 16);
+    EXPECT_TRUE(rc.ok);
+    EXPECT_EQ(std::u32string(out32, rc.written), s32);
+
+    // too small: stops cleanly before the code point that does not fit
+    rc = encodeUtf8(s32, out8, 4);
+    EXPECT_FALSE(rc.ok);
+    EXPECT_EQ(rc.read, 2u);
+    EXPECT_EQ(rc.written, 3u);
+
+    EXPECT_EQ(encodeUtf8Unchecked(s32, out8), s8.size());
+    EXPECT_EQ(decodeUtf8Unchecked(s8, out32), s32.size());
+    EXPECT_EQ(std::u32string(out32, s32.size()), s32);
+}
+
+TEST(utf8cvt, Utf16)
+{
+    std::u32string s32 = {0x0024, 0x20ac, 0x10348};
+    std::u16string s16 = {0x0024, 0x20ac, 0xd800, 0xdf48};
+    std::string s8 = "\x24\xe2\x82\xac\xf0\x90\x8d\x88";
+
+    EXPECT_EQ(encodeUtf16(s32), s16);
+    EXPECT_EQ(utf8ToUtf16(s8), s16);
+
+    char16_t out[8];
+    EXPECT_EQ(utf8ToUtf16Unchecked(s8, out), s16.size());
+    EXPECT_EQ(std::u16string(out, s16.size()), s16);
+}
+
+TEST(utf8cvt, ErrorPositions)
+{
+    char32_t out[16];
+    // overlong, surrogate, truncated, stray continuation
+    EXPECT_EQ(decodeUtf8("ab\xc0\xaf", out, 16).read, 2u);
+    EXPECT_EQ(decodeUtf8("a\xed\xa0\x80", out, 16).read, 1u);
+    EXPECT_EQ(decodeUtf8("abc\xe2\x82", out, 16).read, 3u);
+    EXPECT_FALSE(decodeUtf8("\x80", out, 16).ok);
+
+    char buf[16];
+    std::u32string bad = {U'a', 0xd800};
+    auto rc = encodeUtf8(bad, buf, sizeof(buf));
+    EXPECT_FALSE(rc.ok);
+    EXPECT_EQ(rc.read, 1u);
+
+    EXPECT_THROW(decodeUtf8(std::string("\xff")), std::runtime_error);
+    EXPECT_THROW(encodeUtf8(std::u32string(1, 0x110000)), std::runtime_error);
+}
+
+TEST(utf8cvt, LongAsciiRuns)
+{
+    std::string s8(1000, 'x');
+    s8[997] = '\xc2';
+    s8[998] = '\xa2';
+    auto s32 = decodeUtf8(s8);
+    ASSERT_EQ(s32.size(), 999u);
+    EXPECT_EQ(s32[997], 0xa2u);
+    EXPECT_EQ(encodeUtf8(s32), s8);
+}
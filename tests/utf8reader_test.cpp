@@ -27,3 +27,20 @@
 #include <sstream>
 
 using namespace edncxx;
+
+TEST(utf8reader, OffsetCountsBytes)
+{
+    std::istringstream strm("a\xe2\x82\xac" "b");
+    Utf8Reader rdr(strm);
+    EXPECT_EQ(rdr.get(), U'a');
+    EXPECT_EQ(rdr.offset(), 1u);
+    EXPECT_EQ(rdr.get(), 0x20acu);
+    EXPECT_EQ(rdr.offset(), 4u);
+    EXPECT_EQ(rdr.peek(), U'b');
+    EXPECT_EQ(rdr.offset(), 4u);
+    rdr.unget(0x20ac);
+    EXPECT_EQ(rdr.offset(), 1u);
+    EXPECT_EQ(rdr.get(), 0x20acu);
+    EXPECT_EQ(rdr.get(), U'b');
+    EXPECT_EQ(rdr.offset(), 5u);
+}